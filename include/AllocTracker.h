@@ -0,0 +1,64 @@
+#ifndef ALLOCTRACKER_HPP
+#define ALLOCTRACKER_HPP
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Opt-in heap allocation counters (configure with -DTD_TRACK_ALLOCS=ON).
+// The global operator new/delete are replaced to count every allocation and
+// its size into the current frame and into the innermost profiler zone, so a
+// frame (or a zone inside it) that allocates shows up in the debug overlay and
+// in headless runs. Without the option nothing is replaced and the zone macro
+// compiles away. Counters are plain ints: the game loop is single-threaded.
+class AllocTracker {
+public:
+    struct Counts {
+        std::uint64_t allocs = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t frees = 0;
+    };
+    static constexpr int MaxZones = 32;
+
+#ifdef TD_TRACK_ALLOCS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // closes the running frame (its counts become lastFrame()) and starts a new one
+    static void beginFrame();
+    static const Counts& frame();     // running frame so far
+    static const Counts& lastFrame();
+    static const Counts& total();     // since startup
+
+    // zones are registered once by name (string literals, compared by pointer)
+    static int zoneIndex(const char* name);
+    static int zoneCount();
+    static const char* zoneName(int zone);
+    static const Counts& zoneLastFrame(int zone);
+    static void enterZone(int zone);
+    static void leaveZone();
+
+    class Scope {
+    public:
+        explicit Scope(int zone) { enterZone(zone); }
+        ~Scope() { leaveZone(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // called by the replaced operators
+    static void countAlloc(std::size_t bytes);
+    static void countFree();
+};
+
+// one zone per block: TD_PROFILE_ZONE("enemies");
+#ifdef TD_TRACK_ALLOCS
+#define TD_PROFILE_ZONE(name) \
+    static const int tdZoneId = AllocTracker::zoneIndex(name); \
+    AllocTracker::Scope tdZoneScope(tdZoneId)
+#else
+#define TD_PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif /* ALLOCTRACKER_HPP */
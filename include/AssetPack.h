@@ -0,0 +1,70 @@
+#ifndef ASSETPACK_HPP
+#define ASSETPACK_HPP
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Pre-decoded asset pack produced at build time by tools/asset_packer.cpp.
+// Layout (native endianness): PackHeader, 'count' PackEntry records sorted by
+// name, then the payloads, each 16-byte aligned. Images are stored as raw
+// RGBA8 pixels so loading a texture is a single upload, with no PNG decoding.
+// The pack is either linked into the executable (TD_EMBEDDED_ASSETS) or
+// mmap'ed from an assets.pack file.
+struct PackHeader {
+    char magic[4];          // "TDPK"
+    std::uint32_t version;  // PackVersion
+    std::uint32_t count;    // number of entries
+    std::uint32_t reserved;
+};
+
+struct PackEntry {
+    char name[48];          // path relative to assets/, '/' separated, NUL padded
+    std::uint32_t kind;     // PackRaw or PackImage
+    std::uint32_t width;    // images only
+    std::uint32_t height;
+    std::uint32_t mtime;    // source file's last write, seconds since 1970 (0 = unknown)
+    std::uint64_t offset;   // from the start of the pack
+    std::uint64_t size;     // payload bytes
+};
+
+constexpr std::uint32_t PackVersion = 1;
+constexpr std::uint32_t PackRaw = 0;
+constexpr std::uint32_t PackImage = 1;
+
+class AssetPack {
+public:
+    AssetPack() = default;
+    ~AssetPack();
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // the pack used by the game: the embedded one if linked in, otherwise
+    // assets.pack next to the executable or in the working directory
+    static const AssetPack& shared();
+
+    bool openMemory(const unsigned char* data, size_t size);
+    bool openFile(const std::string& path);
+    bool isOpen() const { return base != nullptr; }
+
+    const PackEntry* find(std::string_view name) const;
+    // upload an image entry into a texture; false if missing
+    bool loadTexture(sf::Texture& texture, std::string_view name) const;
+    // contents of a raw entry (e.g. "Map.txt"); false if missing
+    bool getText(std::string_view name, std::string& out) const;
+    // path exists and was written after the entry was packed (or the entry
+    // is missing): e.g. a map saved by the editor since the last build
+    bool isOlderThan(const std::string& path, std::string_view name) const;
+    // seconds since 1970, as stored in PackEntry::mtime; 0 if path is missing
+    static std::uint32_t fileTime(const std::string& path);
+
+private:
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+    void* mapped = nullptr; // non-null when base comes from mmap
+    const PackEntry* entries = nullptr;
+    std::uint32_t count = 0;
+};
+
+#endif /* ASSETPACK_HPP */
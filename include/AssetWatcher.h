@@ -0,0 +1,30 @@
+#ifndef ASSETWATCHER_HPP
+#define ASSETWATCHER_HPP
+#pragma once
+#include <string>
+#include <vector>
+
+// Watches the assets directory (and its sprites/ and tiles/ subfolders) for
+// files being rewritten, using inotify on Linux. poll() never blocks; on other
+// platforms start() returns false and the game simply runs without hot reload.
+class AssetWatcher {
+public:
+    AssetWatcher() = default;
+    ~AssetWatcher();
+    AssetWatcher(const AssetWatcher&) = delete;
+    AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+    bool start(const std::string& assetsDir);
+    void stop();
+    bool isRunning() const { return fd >= 0; }
+    // paths relative to the assets dir ("Map.txt", "sprites/Fire.png", ...)
+    // changed since the last poll, each reported once
+    void poll(std::vector<std::string>& changed);
+
+private:
+    int fd = -1;
+    struct Watch { int wd; std::string prefix; };
+    std::vector<Watch> watches;
+};
+
+#endif /* ASSETWATCHER_HPP */
@@ -0,0 +1,42 @@
+#ifndef BITBOARDBFS_HPP
+#define BITBOARDBFS_HPP
+#pragma once
+#include <SFML/System.hpp>
+#include <vector>
+#include <cstdint>
+
+// Breadth-first distance field computed a whole layer at a time on bitboards.
+// Each grid row is packed into 64-bit words (bit x = column x) with at least
+// one always-clear padding bit at the end, and the board has an empty guard
+// row above and below. One layer is then a single flat pass over words:
+//   next = (F<<1 | F>>1 | F[row above] | F[row below]) & passable & ~visited
+// (with the carry bits from the neighboring words), which the compiler
+// vectorizes and which has an AVX2 path picked at runtime. Only the word range spanned
+// by the current frontier (plus one row each side) is touched per layer, and a
+// frontier too sparse for that range (long corridors, the thin edges of an
+// open flood) switches to expanding just the words around its active ones.
+class BitboardBfs {
+public:
+    // passable(x, y) is queried once per tile; dist receives cols*rows steps to
+    // the nearest source, -1 where unreachable or blocked
+    template <class Passable>
+    void run(int cols, int rows, Passable&& passable, const std::vector<sf::Vector2i>& sources, std::vector<int>& dist) {
+        resize(cols, rows);
+        std::fill(open.begin(), open.end(), 0);
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < cols; ++x)
+                if (passable(x, y)) open[(y + 1) * stride + (x >> 6)] |= std::uint64_t(1) << (x & 63);
+        search(sources, dist);
+    }
+
+private:
+    int cols = 0, rows = 0;
+    int stride = 0; // words per row
+    std::vector<std::uint64_t> open, visited, frontier, next;
+    std::vector<long> active, candidates;   // frontier words / words to expand
+    std::vector<std::uint32_t> stamp;       // dedupes candidates per layer
+    void resize(int cols, int rows);
+    void search(const std::vector<sf::Vector2i>& sources, std::vector<int>& dist);
+};
+
+#endif /* BITBOARDBFS_HPP */
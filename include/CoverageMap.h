@@ -0,0 +1,55 @@
+#ifndef COVERAGEMAP_HPP
+#define COVERAGEMAP_HPP
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+// Per-tile fire coverage: how many towers reach each tile and the damage per
+// second they can put on it (damage * fire rate, summed). A tower is stamped
+// onto the tiles whose centers its range covers, like the freezing auras, so
+// placing, upgrading or selling one only touches the tiles in its range.
+//
+// The overlay is one texture with a pixel per tile, drawn scaled over the map.
+// Stamps only grow a dirty rect; the next draw recolors that rect and uploads
+// it, nothing else.
+class CoverageMap {
+public:
+    void init(int cols, int rows, float tileSize);
+    void clear();
+    // sign +1 adds a tower, -1 takes back exactly what the +1 added
+    void stamp(const sf::Vector2f& center, float range, float dps, int sign);
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    int coverageAt(int tx, int ty) const {
+        if (tx < 0 || ty < 0 || tx >= cols || ty >= rows) return 0;
+        return count[ty * cols + tx];
+    }
+    float dpsAt(int tx, int ty) const {
+        if (tx < 0 || ty < 0 || tx >= cols || ty >= rows) return 0.f;
+        return dps[ty * cols + tx];
+    }
+    // one line per row: "coverage:dps" per tile, comma separated
+    void write(std::ostream& out) const;
+
+    // dps drawn at full intensity (more saturates)
+    float fullDps = 150.f;
+    void draw(sf::RenderTarget& target);
+
+private:
+    int cols = 0, rows = 0;
+    float tileSize = 1.f;
+    std::vector<std::uint16_t> count;
+    std::vector<float> dps;
+
+    sf::Texture texture;
+    sf::Sprite sprite;
+    bool textureReady = false;
+    int dirtyX0 = 0, dirtyY0 = 0, dirtyX1 = -1, dirtyY1 = -1; // inclusive, empty if x1 < x0
+    std::vector<sf::Uint8> pixels; // upload scratch for the dirty rect
+    void markDirty(int x0, int y0, int x1, int y1);
+};
+
+#endif /* COVERAGEMAP_HPP */
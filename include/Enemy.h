@@ -4,11 +4,16 @@
 #include "ElementGraphique.h"
 #include <SFML/Graphics.hpp>
 #include <vector>
-#include <random>
+#include <memory>
+#include <cstdint>
 
 class Game; // forward
 
-class Enemy : public ElementGraphique {
+// terrain rules an enemy moves by; each class gets its own distance field
+enum class MoveClass : std::uint8_t { Ground, Heavy, Flyer };
+constexpr int MoveClassCount = 3;
+
+class Enemy : public ElementGraphique, public std::enable_shared_from_this<Enemy> {
     sf::RectangleShape shape;
     float speed = 80.f; // px/s
     // path-following (optional)
@@ -20,29 +25,80 @@ class Enemy : public ElementGraphique {
     int tx = 0, ty = 0; // current tile coords
     int prevTx = -1, prevTy = -1;
     sf::Vector2f targetPos; // target center when moving
-    std::mt19937 rng;
 
-    int type = 1; // enemy type (1 or 2)
+    int type = 1; // enemy type (1 = ground, 2 = heavy, 3 = flyer)
+    MoveClass moveClass = MoveClass::Ground;
     sf::Sprite sprite;
     // HP and status
     float hp = 50.f;
     bool alive = true;
     float radius = 12.f;
+    std::uint32_t serial = 0;
+
+    // status effects: one flag byte, timers only ticked while their flag is set
+    std::uint8_t status = 0;
+    float burnTimer = 0.f, burnDps = 0.f;
+    int burnTowerId = -1;
+    float stunTimer = 0.f;
+    void updateStatus(float dt);
+    float currentSpeed(const sf::Vector2f& pos) const; // speed after freezing auras (Game::slowGrid)
+    // neighbour (or the tile itself) with the lowest field value; returns that value
+    int nextTile(int curTx, int curTy, int& bestX, int& bestY) const;
 
 public:
+    enum StatusFlag : std::uint8_t { StatusBurn = 1, StatusStun = 2 };
+
     // allow setting hp at construction
     Enemy(const sf::Vector2f& start, Game* gamePtr = nullptr, float initialHP = 50.f, int type = 1);
 
+    // back to a freshly spawned enemy (Game recycles dead enemies instead of
+    // allocating new ones); the shape keeps its vertex storage
+    void reset(const sf::Vector2f& start, float initialHP, int type);
+    // bumped by every reset, so a handle taken earlier can tell it was recycled
+    std::uint32_t getSerial() const { return serial; }
+
     void setPath(const std::vector<sf::Vector2f>& p);
     void update(float dt) override;
     void render(sf::RenderWindow& window) override;
+    // plain shape even when a sprite is loaded (low quality level)
+    void renderCheap(sf::RenderWindow& window);
     sf::Vector2f getPosition() const override;
     
     // HP and damage
-    void takeDamage(float dmg);
+    // towerId is credited with the kill if this damage is lethal
+    void takeDamage(float dmg, int towerId = -1);
+    int getType() const { return type; }
+    float getHP() const { return hp; }
+    MoveClass getMoveClass() const { return moveClass; }
+    static MoveClass moveClassOf(int type) {
+        return type == 2 ? MoveClass::Heavy : type == 3 ? MoveClass::Flyer : MoveClass::Ground;
+    }
+    // body colour without a sprite; death bursts use it too
+    static sf::Color fillColorOf(int type) {
+        // flyers have no sprite yet: a pale blue square
+        return moveClassOf(type) == MoveClass::Flyer ? sf::Color(120, 180, 255) : sf::Color(200, 50, 50);
+    }
     bool isAlive() const;
     float getRadius() const;
+
+    // status effects (re-applying refreshes the duration); slows come from
+    // the freezing auras only, see currentSpeed
+    void applyBurn(float dps, float duration, int towerId);
+    void applyStun(float duration);
+    bool hasStatus(std::uint8_t flag) const { return (status & flag) != 0; }
+
+    // movement along the distance field of our class; returns false once the base tile is reached
+    bool stepAlongField(sf::Vector2f& pos, float step) const;
+    // remaining cost to a base in field units, fractional within a tile
+    // (lower = further along); ProgressIndex::Unranked without a path
+    float getProgress() const;
+    // where the enemy will be in t seconds if it keeps following the field
+    sf::Vector2f predictPosition(float t) const;
     
+    // crowd separation push; the enemy is kept inside the walkable core of its
+    // current tile so it never leaves the flow-field route
+    sf::Vector2f nudge(const sf::Vector2f& delta);
+
     // helpers
     void snapToTileCenter();
 };
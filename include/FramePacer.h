@@ -0,0 +1,31 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+#pragma once
+#include <SFML/System.hpp>
+
+// Frame cap without busy-waiting the whole frame: wait() sleeps until just
+// before the next frame is due, then yields for the last stretch. The margin
+// kept for that stretch follows how late the OS actually wakes us (a running
+// average of the oversleep), so the cap stays precise on a coarse scheduler
+// while burning as little CPU as possible on a fine one. Deadlines advance by
+// whole periods; a frame that ran long resyncs instead of rushing the next ones.
+class FramePacer {
+public:
+    // 0 = uncapped (vsync or nothing paces the loop)
+    void setTargetFps(int fps);
+    int getTargetFps() const { return fps; }
+    // blocks until the next frame is due; call once per frame, after display()
+    void wait();
+    // forget the current deadline (after an idle stretch or a mode change)
+    void reset() { next = sf::Time::Zero; }
+    float getSleepMargin() const { return margin.asSeconds(); }
+
+private:
+    int fps = 0;
+    sf::Time period = sf::Time::Zero;
+    sf::Time next = sf::Time::Zero;
+    sf::Time margin = sf::microseconds(1000); // expected oversleep
+    sf::Clock clock;
+};
+
+#endif /* FRAMEPACER_HPP */
@@ -4,8 +4,23 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <memory>
-#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <random>
 #include "ElementGraphique.h"
+#include "TimerWheel.h"
+#include "SpatialGrid.h"
+#include "AssetWatcher.h"
+#include "HierarchicalPaths.h"
+#include "BitboardBfs.h"
+#include "FramePacer.h"
+#include "Lockstep.h"
+#include "ParticleSystem.h"
+#include "QualityGovernor.h"
+#include "ProgressIndex.h"
+#include "CoverageMap.h"
+#include "WaveDirector.h"
+#include "MapEditor.h"
 #include "Map.h"
 #include "Enemy.h"
 #include "Tower.h"
@@ -18,84 +33,352 @@ public:
     sf::RenderWindow window;
     Map map;
     sf::Clock clock;
+    // Simulation timers (tower reloads, spawns, waves, scheduled hits).
+    // Declared before the entities: towers cancel their timers when destroyed.
+    TimerWheel timers;
     
     // Entities
     std::vector<std::shared_ptr<Enemy>> enemies;
     std::vector<std::unique_ptr<Tower>> towers;
     std::vector<std::unique_ptr<Projectile>> projectiles;
+    // spent entities are parked here and reset on reuse, so a steady wave does
+    // not allocate (recycled enemies get a new serial, see ScheduledHit)
+    std::vector<std::shared_ptr<Enemy>> enemyPool;
+    std::vector<std::unique_ptr<Projectile>> projectilePool;
     std::unique_ptr<GameUI> ui;  // UI system
+    SpatialGrid enemyGrid;       // enemies bucketed per tile, rebuilt every update
+    ProgressIndex progress;      // enemies by path progress, refreshed every update
+    // crowd separation: enemies closer than (r1 + r2) * crowdSpacing push apart,
+    // resolving crowdStiffness of the overlap per second
+    float crowdSpacing = 0.9f;
+    float crowdStiffness = 8.f;
+    std::vector<float> crowdPushX, crowdPushY;
+    void separateCrowd(float dt);
     
     // Economy
     int money = 200; // starting money (user requested 150-200 dollars)
+    int killReward = 10;
+
+    // Death events: enemies and projectiles report why they died during a tick,
+    // economy and stats consume the queue once per tick in processDeathEvents()
+    enum class DeathCause { KilledByTower, Leaked, Expired };
+    struct DeathEvent {
+        DeathCause cause;
+        int towerId;      // killing / firing tower, -1 if none
+        int enemyType;    // 0 for projectiles
+        sf::Vector2f pos;
+    };
+    std::vector<DeathEvent> deathEvents;
+    struct MatchStats {
+        int kills = 0;
+        int leaks = 0;
+        int expiredShots = 0; // shots that missed or lost their target
+    };
+    MatchStats stats;
+    int liveEnemies = 0;          // spawned and not yet dead
+    int nextTowerId = 0;
+    std::vector<Tower*> towerById; // index = Tower::getId(), nullptr once removed
     
     // Player Health
     int playerHealth = 20;
     bool gameOver = false;
     
-    // Wave system
+    // Wave system: waves come from assets/waves.txt and are run by coroutines
+    // (see WaveDirector), which set currentWave
     int currentWave = 0;
-    float waveTimer = 0.f;
-    float waveCooldown = 5.f;  // seconds between waves
-    // Spawn queue: sequential spawn to form battalions
-    struct SpawnInfo { int type; float hp; };
-    std::deque<SpawnInfo> spawnQueue;  // queue of enemies to spawn (type + HP)
-    float spawnInterval = 0.6f; // seconds between spawns
-    float spawnTimer = 0.f;     // timer until next spawn
-    float enemyBaseHP = 50.f;   // base hp for enemies
-    float enemyHpScale = 10.f;  // additional hp per wave
-    float nextSpawnHP = 50.f;   // HP for next spawns
-    int spawnTileX = -1;
-    int spawnTileY = -1;
+    struct SpawnInfo { int type; float hp; int spawn; }; // spawn = index into spawnPoints
+    // enemies drawn by the bursts in flight, released in order; a vector so
+    // refilling it every wave reuses its storage
+    std::vector<SpawnInfo> spawnQueue;
+    int pendingSpawns = 0;      // drawn and not released yet
+    std::vector<sf::Vector2i> spawnPoints; // spawn tiles used by the current wave
+    // declared after the queue it fills: destroyed first
+    WaveDirector waves{*this};
+    // pack first, then assets/waves.txt; fromFiles reads the file (hot reload)
+    void loadWaveScript(bool fromFiles = false);
+    // assets/<name> (or ../assets/) was written after the pack was built
+    bool hasNewerFile(const std::string& name) const;
     // Textures for sprites and projectiles
     sf::Texture enemy1Texture;
     sf::Texture enemy2Texture;
     sf::Texture fireArrowTexture;
     bool texturesLoaded = false;
+    // Hot reload: the assets dir the map was loaded from is watched, changed
+    // files are reloaded in place without restarting the match (sprites and
+    // tiles only in co-op: the peer would not get the new map or waves)
+    std::string assetsDir = "assets";
+    AssetWatcher assetWatcher;
+    std::vector<std::string> changedAssets;
     // Portal animation (vortex) timer
     float portalAnimTime = 0.f;
-    float spawnPortalPulse = 0.f; // pulse factor 0..1
-    float basePortalPulse = 0.f; // pulse factor 0..1
+    // Portal pulses are evaluated from timestamps when drawn, nothing decays per frame
+    struct Pulse {
+        float level = 0.f; // value at 'since'
+        float since = 0.f; // simTime of the last change
+        float rate = 0.f;  // per second (+ rising, - decaying)
+        float at(float t) const { return std::clamp(level + rate * (t - since), 0.f, 1.f); }
+        void set(float t, float newLevel, float newRate) { level = newLevel; since = t; rate = newRate; }
+    };
+    Pulse spawnPortalPulse; // 0..1
+    Pulse basePortalPulse;  // 0..1
+    // explosions, fire, kills and leaks; visual only (empty when headless)
+    ParticleSystem particles;
+    int particleCapacity = 65536;
+    sf::CircleShape portalRing, portalDisc; // reused by drawPortals
+    sf::ConvexShape portalArm;
     
+    // Hit resolution: Collision tests every projectile against every enemy each frame,
+    // Scheduled predicts the intercept at fire time and applies damage as a timed event
+    enum class HitMode { Collision, Scheduled };
+    HitMode hitMode = HitMode::Scheduled;
+    float simTime = 0.f; // seconds of simulated (unpaused) time
+    std::uint64_t simTicks = 0; // update() steps since the match started
+    // all gameplay randomness comes from here, reseeded per match
+    std::mt19937 rng;
+    int randomInt(int n) { return static_cast<int>(rng() % static_cast<unsigned>(n)); }
+    struct ScheduledHit {
+        std::weak_ptr<Enemy> target;
+        std::uint32_t serial;   // target's serial at fire time
+        float damage;
+        int towerId;
+        int projType;
+    };
+    // hits in flight, indexed by the timer that resolves them (slots are recycled)
+    std::vector<ScheduledHit> scheduledHits;
+    std::vector<int> freeHitSlots;
+
+    // Camera: the world is drawn through a pannable/zoomable view and culled
+    // against it, the UI is drawn with uiView (window pixels)
+    sf::View camera;
+    sf::View uiView;
+    float cameraZoom = 1.f;     // world units per window pixel
+    float cameraPanSpeed = 600.f; // window pixels per second (arrow keys)
+    bool draggingCamera = false;
+    sf::Vector2i dragLastPixel;
+    void resetCamera();
+    void clampCamera();
+    bool updateCamera(float dt); // true if the view moved
+    void zoomCamera(float factor, const sf::Vector2i& pixel);
+    sf::FloatRect getVisibleWorldRect() const;
+    sf::Vector2f pixelToWorld(int px, int py) const { return window.mapPixelToCoords({px, py}, camera); }
+
     // Tower placement
     int selectedTowerType = 0;  // 0=Sniper, 1=Freezing, 2=Cannon
     bool placingTower = false;
     sf::Vector2f previewPos = {-1000, -1000};
+    // a click on a tower (while not placing one) selects it; T cycles its
+    // targeting policy
+    int selectedTowerId = -1;
+    sf::CircleShape selectionRing;
+    Tower* getSelectedTower() const {
+        if (selectedTowerId < 0 || selectedTowerId >= static_cast<int>(towerById.size())) return nullptr;
+        return towerById[selectedTowerId];
+    }
+    Tower* towerAtTile(int tx, int ty) const;
     
     // BFS
-    std::vector<std::vector<int>> distance;
-    std::vector<std::vector<sf::Vector2i>> came_from;
+    std::vector<int> distance; // cols*rows steps to the nearest base, -1 = blocked/unreachable
+    BitboardBfs bitBfs;
     std::vector<std::vector<bool>> tileBlocked; // track blocked tiles (towers)
+    // maps of at least hierarchicalMinTiles tiles route through clustered
+    // portal graphs instead of one full-grid BFS per change
+    HierarchicalPaths hierarchy{16};
+    bool useHierarchy = false;
+    int hierarchicalMinTiles = 256 * 256;
+    // weighted distance fields of the non-ground movement classes: computed on
+    // first use, repaired around edited tiles, dropped on full path rebuilds
+    // and while no enemy of the class is alive (ground uses distance/hierarchy above)
+    struct ClassField {
+        std::vector<int> dist; // cols*rows, -1 = impassable or unreachable
+        bool valid = false;
+        int live = 0;          // enemies of this class currently alive
+    };
+    mutable ClassField classFields[MoveClassCount];
+    mutable std::vector<std::pair<int, int>> classHeap; // computeClassField scratch
+    std::vector<std::uint32_t> classMark;                // repairClassField scratch
+    std::uint32_t classMarkStamp = 0;
+    std::vector<int> classReset;
+    // cost of crossing a tile for a class, -1 = impassable
+    int tileCost(MoveClass mc, int tx, int ty) const;
+    void computeClassField(MoveClass mc) const;
+    // Dijkstra from what classHeap holds
+    void runClassSearch(MoveClass mc) const;
+    // tiles (or towers on them) changed: the valid class fields are repaired
+    // around them instead of being recomputed on their next use
+    void repairClassFields(const sf::Vector2i* tiles, int count);
+    void repairClassField(MoveClass mc, const sf::Vector2i* tiles, int count);
+    void invalidateClassFields();
+    std::uint32_t fieldVersion = 0; // bumped whenever any field may change
+    // changes when the field values towers target by may have: field version
+    // plus which classes are alive (see Tower::updateBand)
+    std::uint64_t targetingStamp() const {
+        std::uint64_t mask = 0;
+        for (int c = 0; c < MoveClassCount; ++c)
+            if (classFields[c].live > 0) mask |= 1u << c;
+        return static_cast<std::uint64_t>(fieldVersion) << MoveClassCount | mask;
+    }
+    // Which tiles can take a tower (cols*rows, 1 = valid), rebuilt whenever the
+    // map or the towers change. Besides the tile/ban rules, a tile is invalid
+    // when it is a cut vertex whose removal separates a spawn from every base:
+    // one iterative Tarjan DFS from a virtual root linked to all bases, counting
+    // spawns per DFS subtree, answers that for the whole map at once.
+    std::vector<std::uint8_t> placementValid;
+    std::vector<int> dfsDisc, dfsLow, dfsParent, dfsSpawns; // rebuild scratch
+    std::vector<int> dfsNext, dfsCut, dfsStack;
+    std::vector<std::uint8_t> dfsTile;
+    void rebuildPlacementValidity();
+    // Freezing auras rasterized per tile (speed factor, 1 = no slow); rebuilt only
+    // when towers change so enemies look their slow up in O(1)
+    std::vector<float> slowGrid;
+    // fire coverage per tile (towers in reach, summed dps), stamped per tower
+    // as they are placed, upgraded and sold; H shows it over the map
+    CoverageMap coverage;
+    bool showCoverage = false;
+    void rebuildCoverage();
+    // E: paint the map in place (not in co-op)
+    MapEditor editor{*this};
+    // tiles changed by the editor: repairs the distance fields for them only
+    // (placement validity is left to the caller, see MapEditor::close)
+    void applyTileEdits(const std::vector<sf::Vector2i>& tiles);
     bool paused = false;
     int placementBanRadiusTiles = 2; // cannot place towers within this radius of spawn or base
     bool gameStarted = false; // main menu/started state
     int startingMoney = 200; // default starting money used at reset
 
-    Game();
+    // headless: no window, textures or UI; the simulation is driven by runHeadless()
+    explicit Game(bool headless = false);
     void run();
+    // fixed 1/60 s ticks with towers placed automatically, prints a summary.
+    // allocTest: after a warm-up, any tick that allocates fails the run
+    // (needs TD_TRACK_ALLOCS); returns the process exit code
+    // speed > 1: drive advanceSimulation() with 60 FPS frames at that speed
+    int runHeadless(int ticks, bool allocTest, int speed = 1);
+    bool headless = false;
+    bool showDebug = false; // F3: frame time and allocation counters
+    float frameTime = 0.f;  // seconds, last frame
+    // frame pacing: vsync, or a software cap (0 = uncapped); V toggles vsync
+    bool vsync = false;
+    int frameCap = 60;
+    int idlePollMs = 30;    // event polling interval on idle screens
+    FramePacer pacer;
+    void applyFramePacing();
+    // detail level from the frame time (F4 turns it off: full detail)
+    QualityGovernor quality;
+    sf::Clock workClock;       // time spent drawing the current frame (simulation and present excluded)
+    void applyQuality();
+    sf::Vector2f mouseWorld;   // last cursor position, world coordinates
+    int pinnedWave = -1;    // >= 0: every wave repeats this one (headless runs)
+    std::string coverageOut; // headless: the coverage map is written here at the end
+
+    // Fast-forward: the simulation always steps by SimStep, whatever the speed,
+    // so x16 plays out exactly like x1, just with more steps per frame. Tab
+    // cycles the speed. When a frame can't fit all its steps (maxStepsPerFrame
+    // or stepBudget seconds of work) the rest is dropped and the game runs
+    // slower than asked instead of spiralling.
+    static constexpr float SimStep = 1.f / 60.f;
+    static constexpr int SpeedLevels[] = {1, 2, 4, 16};
+    static constexpr int SpeedLevelCount = 4;
+    int speedIndex = 0;
+    int maxStepsPerFrame = 40;
+    float stepBudget = 0.012f;  // seconds of update() work per frame
+    float simAccumulator = 0.f; // pending steps (in ticks, not seconds)
+    float effectiveSpeed = 1.f; // achieved speed, smoothed
+    int behindFrames = 0;       // consecutive frames that dropped steps
+    int getSimSpeed() const { return SpeedLevels[speedIndex]; }
+    bool isSimBehind() const { return behindFrames > 0; }
+    void advanceSimulation(float frameDt);
+    void cycleSimSpeed();
+    // --seed: replay a match; otherwise every match draws a fresh seed
+    unsigned matchSeed = 0;
+    bool seedFixed = false;
+    // hash of the simulated state, identical for identical seed + inputs + tick
+    std::uint64_t stateHash() const;
+    // one fixed step; false when a co-op match is waiting for the peer's inputs
+    bool stepSimulation();
+
+    // Co-op: with a session, gameplay inputs become commands that both sides
+    // apply at the same tick (see Lockstep). Money and towers are shared; pause,
+    // fast-forward and restart are off since they would need the peer to agree.
+    std::unique_ptr<Lockstep> net;
+    sf::Clock netClock;
+    bool netReported = false;   // desync / peer loss already printed
+    int netStallFrames = 0;     // consecutive frames spent waiting for the peer's inputs
+    // receive; starts the match on connect. true if something changed
+    bool pollNet(sf::Time now);
+    void issueCommand(const Lockstep::Command& c);
+    void applyCommand(const Lockstep::Command& c);
+    // two headless games over localhost UDP with a lossy simulated link,
+    // scripted placements on both sides; fails on desync or a stall
+    static int runNetTest(int ticks, sf::Time latency, sf::Time jitter, float loss, int desyncAt = -1);
+    // collision mode: two shots into one enemy in the same tick, the second
+    // must not be stopped by the first one's kill
+    static int runHitTest();
     void startNewGame();
     Map& getMap() { return map; }
     const Map& getMap() const { return map; }
-    const std::vector<std::vector<int>>& getDistance() const { return distance; }
-    std::vector<sf::Vector2i> getNeighborsPublic(int tx, int ty) const { return getNeighbors(tx, ty); }
+    // cost from a tile to the nearest base for a movement class (steps for
+    // ground enemies), -1 if blocked or unreachable
+    int getDistanceAt(int tx, int ty, MoveClass mc = MoveClass::Ground) const {
+        if (mc != MoveClass::Ground) {
+            if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows()) return -1;
+            const ClassField& f = classFields[static_cast<int>(mc)];
+            if (!f.valid) computeClassField(mc);
+            return f.dist[ty * map.getCols() + tx];
+        }
+        if (useHierarchy) return hierarchy.distanceAt(tx, ty);
+        if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows() || distance.empty()) return -1;
+        return distance[ty * map.getCols() + tx];
+    }
+    bool hasDistanceField() const { return useHierarchy ? !hierarchy.empty() : !distance.empty(); }
     
     // Gameplay
-    void spawnEnemyWave(int count);
-    void cleanupDeadStuff();
+    void reportDeath(DeathCause cause, int towerId, int enemyType, const sf::Vector2f& pos);
+    void processDeathEvents();  // economy + stats for everything that died this tick
     void damagePlayer(int dmg);  // called when enemy reaches base
-    int getWaveEnemyCount(int wave) const;  // returns enemy count for given wave
+    // fire a projectile from a tower at a target (honours hitMode)
+    void fireProjectile(const Tower& from, const std::shared_ptr<Enemy>& target, float speed, float damage, int projType);
+    void resolveScheduledHit(int slot);
+    // damage + on-hit status effects of a projectile (both hit modes)
+    void applyProjectileHit(Enemy& e, float damage, int towerId, int projType);
+    void rebuildSlowGrid();
+    float getSlowAt(int tx, int ty) const {
+        if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows() || slowGrid.empty()) return 1.f;
+        return slowGrid[ty * map.getCols() + tx];
+    }
+    void spawnEnemy(const SpawnInfo& info); // from the pool when it can
+    void reserveEntityStorage(); // capacity for the current wave and towers
     
     // Tower placement
     void placeTower(int towerType);  // 0=Sniper, 1=Freezing, 2=Cannon
+    bool canPlaceAt(int tx, int ty) const {
+        if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows() || placementValid.empty()) return false;
+        return placementValid[ty * map.getCols() + tx] != 0;
+    }
     void handleMouseMove(const sf::Vector2f& mousePos);
     void handleMouseClick(const sf::Vector2f& mousePos);
+    // build a tower of the given type on a tile if it is allowed and affordable
+    bool tryPlaceTower(int towerType, int tx, int ty);
+    // by tower id; upgrading needs the money, selling refunds Tower::getSellValue()
+    bool tryUpgradeTower(int id);
+    bool trySellTower(int id);
     
 private:
-    void processEvents();
+    // refund (sell value), free its tile and drop it, keeping the tower order;
+    // paths, auras and coverage are left to the caller
+    void removeTower(Tower* t);
+    bool processEvents();        // true if any event arrived
     void update(float dt);
-    void render();
-    std::vector<sf::Vector2i> getNeighbors(int tx, int ty) const;
+    void render();               // draws the frame; run() presents it
     void computeBFS();
+    // distance field only (computeBFS also rebuilds placement validity)
+    void computeDistanceField();
+    // a tile's tower state changed: full BFS on small maps, one cluster otherwise
+    void updatePathsAt(int tx, int ty);
     void drawPortals(sf::RenderWindow& window);
+    // pack first; fromFiles reads assets/ directly (hot reload)
+    void loadTextures(bool fromFiles = false);
+    bool pollAssetChanges();     // true if something was reloaded
+    void reloadMap();
 };
 
 
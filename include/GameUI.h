@@ -13,13 +13,33 @@ private:
     sf::Font font;
     bool fontLoaded = false;
 
+    // texts are built once and only re-set when the value they show changes
+    // (sf::Text::setString allocates), so a steady frame costs no allocation
+    sf::Text healthText, waveText, moneyText, controlsText, towerText;
+    sf::Text gameOverText, pausedText, debugText, speedText;
+    sf::Text menuTitle, menuStart, overTitle, overRestart, menuWaiting;
+    sf::Text netText, selectionText, coverageText, editorText;
+    int shownHealth = -1, shownWave = -1, shownEnemies = -1, shownMoney = -1;
+    int shownTowerType = -1;
+    bool shownAffordable = false;
+    int shownSpeed = -1, shownAchieved = -1; // achieved speed in tenths, -1 = on pace
+    int shownNetState = -1;
+    int shownSelected = -1, shownPolicy = -1, shownKills = -1, shownLevel = -1;
+    int shownCoverage = -1, shownCoverageDps = -1;
+    int shownEditor = -1; // MapEditor revision
+    float debugRefresh = 0.f; // seconds until the debug text is rebuilt
+    unsigned long long shownDropped = 0; // particle drops already counted in the overlay
+
 public:
     GameUI(const Game* g);
     void render(sf::RenderWindow& window);
-    
+    // full-screen start menu / game over screens (drawn after render())
+    void renderOverlay(sf::RenderWindow& window);
+
 private:
     std::string getTowerName(int type) const;
     int getTowerCost(int type) const;
+    void renderDebug(sf::RenderWindow& window);
 };
 
 #endif /* GAMEUI_HPP */
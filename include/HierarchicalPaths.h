@@ -0,0 +1,91 @@
+#ifndef HIERARCHICALPATHS_HPP
+#define HIERARCHICALPATHS_HPP
+#pragma once
+#include <SFML/System.hpp>
+#include <vector>
+#include <cstdint>
+#include <climits>
+
+// HPA*-style distance-to-base for very large maps. The grid is cut into
+// square clusters; every run of open tiles along a cluster border becomes one
+// or two portal node pairs, and each cluster stores the in-cluster step costs
+// between its nodes. A Dijkstra over that abstract graph (from the base tiles)
+// gives every node its distance to the nearest base; tile distances are then
+// filled lazily, one cluster at a time, from the cluster's nodes.
+// Blocking or opening a tile only rebuilds its cluster and the borders it
+// touches, so placement cost is bounded by the cluster size, not the map size.
+class HierarchicalPaths {
+public:
+    explicit HierarchicalPaths(int clusterSize = 16) : clusterSize(clusterSize) {}
+
+    // full build; open is cols*rows row-major (non-zero = walkable)
+    void build(int cols, int rows, const std::vector<std::uint8_t>& open, const std::vector<sf::Vector2i>& bases);
+    void clear();
+    bool empty() const { return clusters.empty(); }
+    // a tile became walkable or blocked: rebuilds the touched clusters and
+    // re-runs the abstract search
+    void setOpen(int tx, int ty, bool open);
+    // batched edits (map editor strokes): stage any number of tiles, then
+    // commit() rebuilds each touched cluster and border once and repairs the
+    // abstract search once. Staging a tile that did not change is free
+    void stageOpen(int tx, int ty, bool open);
+    void stageBase(int tx, int ty, bool base);
+    void commit();
+    // steps to the nearest base following the abstract graph, -1 if unreachable
+    int distanceAt(int tx, int ty) const;
+
+    int getClusterSize() const { return clusterSize; }
+    size_t nodeCount() const { return nodes.size() - freeNodes.size(); }
+
+private:
+    static constexpr int Unreached = INT_MAX;
+    struct Node {
+        int x = 0, y = 0;
+        int cluster = -1;
+        int partner = -1; // node across the border, -1 for bases
+        int slot = 0;     // index in its cluster's node list
+        bool alive = false;
+    };
+    struct Cluster {
+        int x0 = 0, y0 = 0, w = 0, h = 0;
+        std::vector<int> nodes;
+        std::vector<int> cost;      // nodes.size()^2 in-cluster steps, -1 = no path
+        // lazy tile distances (w*h), filled on the first query after a change
+        mutable std::vector<int> field;
+        mutable bool fieldValid = false;
+    };
+
+    int clusterSize;
+    int cols = 0, rows = 0, ccols = 0, crows = 0;
+    std::vector<std::uint8_t> open;
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    std::vector<Cluster> clusters;
+    // portal nodes per border, stored as (near side, far side) pairs
+    std::vector<std::vector<int>> vBorders; // between (cx,cy) and (cx+1,cy)
+    std::vector<std::vector<int>> hBorders; // between (cx,cy) and (cx,cy+1)
+    std::vector<int> absDist;
+    std::vector<int> parent; // shortest-path tree over the abstract graph, -1 at roots
+    // staged since the last commit
+    std::vector<int> stagedClusters;
+    std::vector<int> stagedBorders;       // clusters whose vBorder (bit 0) / hBorder (bit 1) is stale
+    std::vector<std::uint8_t> clusterStaged, borderStaged;
+
+    bool isOpen(int x, int y) const { return open[y * cols + x] != 0; }
+    int clusterOf(int x, int y) const { return (y / clusterSize) * ccols + x / clusterSize; }
+    int allocNode(int x, int y, int partner);
+    void freeNode(int id);
+    void rebuildBorder(bool vertical, int cx, int cy);
+    void rebuildIntra(int c);
+    void stageCluster(int c);
+    void stageBorder(bool vertical, int c);
+    // full Dijkstra from the bases
+    void searchAbstract();
+    // repair after the given clusters were rebuilt: only the shortest-path
+    // subtrees hanging off them are invalidated and searched again
+    void repairAbstract(const int* touched, int count);
+    template <class F> void forEachNeighbor(int id, F&& f) const;
+    void fillField(const Cluster& c) const;
+};
+
+#endif /* HIERARCHICALPATHS_HPP */
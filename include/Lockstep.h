@@ -0,0 +1,135 @@
+#ifndef LOCKSTEP_HPP
+#define LOCKSTEP_HPP
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <random>
+
+// Two-player lockstep over UDP. The simulation is deterministic (fixed steps,
+// seeded rng), so the peers only exchange what the players did: every tick
+// each side closes an input frame (the commands issued since the last one)
+// that applies inputDelay ticks later, and a tick may only run once both
+// players' frames for it are in. Nothing about enemies ever goes on the wire,
+// so a packet stays a few dozen bytes however big the wave is.
+//
+// There are no retransmit timers: every packet repeats all the frames the peer
+// has not acknowledged yet, so a lost packet is covered by the next one. Each
+// side also sends the hash of its state after every tick; the first tick where
+// the two disagree is reported as a desync.
+//
+// All storage is fixed-size rings; the session itself never allocates.
+class Lockstep {
+public:
+    enum class CommandKind : std::uint8_t { None, PlaceTower, SetPolicy, UpgradeTower, SellTower };
+    struct Command {
+        CommandKind kind = CommandKind::None;
+        // PlaceTower: type, tile x, tile y
+        // SetPolicy: tower id, TargetPolicy
+        // UpgradeTower, SellTower: tower id
+        std::int16_t a = 0, b = 0, c = 0;
+    };
+    static constexpr int MaxCommandsPerFrame = 8;
+    static constexpr int Window = 256;   // ring size, in ticks
+    static constexpr int MaxInputDelay = 30;
+
+    // host: listens on port and picks the match seed and the input delay;
+    // the client sends to hostAddress:port from any local port and adopts
+    // both. The delay should cover the one-way latency plus a frame or two,
+    // or every tick ends up waiting for the peer (6 ticks = 100 ms)
+    bool host(unsigned short port, unsigned seed, int inputDelay = 6);
+    bool join(const sf::IpAddress& hostAddress, unsigned short port);
+    unsigned short getLocalPort() const { return socket.getLocalPort(); }
+
+    // simulated link for testing: every outgoing packet is held latency
+    // (+ up to jitter) and dropped with probability loss
+    void simulateLink(sf::Time latency, sf::Time jitter, float loss);
+
+    // now: any monotonic clock (the test harness uses simulated time)
+    void receive(sf::Time now);
+    void send(sf::Time now);
+
+    bool isConnected() const { return connected; }
+    bool isPeerLost() const { return peerLost; }
+    int getPlayer() const { return player; }
+    unsigned getSeed() const { return seed; }
+    int getInputDelay() const { return inputDelay; }
+
+    // local input: applied on both sides at the tick of the next closed frame.
+    // false if that frame is full
+    bool submit(const Command& c);
+    // both players' frames for tick are known
+    bool isReady(std::uint32_t tick) const { return tick < remoteNext; }
+    // call once per simulated tick, before running it: closes the local frame
+    // for tick + inputDelay and returns the commands for tick, both players,
+    // host first (the same order on both sides)
+    int beginTick(std::uint32_t tick, Command* out, int max);
+    // state hash after tick ran
+    void endTick(std::uint32_t tick, std::uint64_t hash);
+
+    bool isDesynced() const { return desyncTick >= 0; }
+    long long getDesyncTick() const { return desyncTick; }
+    std::uint32_t getVerifiedTicks() const { return verifiedNext; }
+    struct Stats {
+        std::uint64_t packetsSent = 0, packetsReceived = 0, packetsDropped = 0;
+        std::uint64_t bytesSent = 0, bytesReceived = 0;
+        std::uint64_t commandsSent = 0;
+    };
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Frame {
+        std::uint32_t tick = ~0u;
+        int count = 0;
+        Command cmds[MaxCommandsPerFrame];
+    };
+    struct Hash {
+        std::uint32_t tick = ~0u;
+        std::uint32_t value = 0;
+    };
+    struct Delayed {
+        sf::Time due;
+        std::size_t size = 0;
+        std::uint8_t data[1024];
+    };
+    static constexpr int MaxDelayed = 64;
+    static constexpr int MaxFramesPerPacket = 32;
+    static constexpr int MaxHashesPerPacket = 32;
+
+    sf::UdpSocket socket;
+    sf::IpAddress peerAddress;
+    unsigned short peerPort = 0;
+    int player = 0;               // 0 = host, 1 = client
+    unsigned seed = 0;
+    bool connected = false;
+    bool peerLost = false;
+    sf::Time lastHeard, lastSent;
+    int inputDelay = 6;           // ticks between issuing a command and running it
+
+    Frame pending;                // local commands not yet in a frame
+    Frame localFrames[Window], remoteFrames[Window];
+    std::uint32_t localNext = 0;  // first local frame not closed yet
+    std::uint32_t remoteNext = 0; // first remote frame not received yet
+    std::uint32_t peerFrameAck = 0; // peer has all our frames below this
+    Hash localHashes[Window], remoteHashes[Window];
+    std::uint32_t localHashNext = 0, remoteHashNext = 0;
+    std::uint32_t peerHashAck = 0;
+    std::uint32_t verifiedNext = 0; // ticks below this matched on both sides
+    long long desyncTick = -1;
+
+    // link simulation
+    sf::Time latency, jitter;
+    float loss = 0.f;
+    std::mt19937 linkRng{12345}; // not the game's rng: must not touch the simulation
+    Delayed delayed[MaxDelayed];
+    int delayedCount = 0;
+    Stats stats;
+
+    void reset();
+    void resetTicks();
+    void transmit(const std::uint8_t* data, std::size_t size, sf::Time now);
+    void flushDelayed(sf::Time now);
+    void handlePacket(const std::uint8_t* data, std::size_t size, sf::Time now);
+    void compareHashes();
+};
+
+#endif /* LOCKSTEP_HPP */
@@ -4,6 +4,7 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <string>
+#include <iosfwd>
 
 class Map {
 private:
@@ -15,12 +16,56 @@ private:
     sf::Texture pavingTexture;
     sf::Texture stoneTexture;
     bool texturesLoaded = false;
+    // index of special tiles (spawn = 4, base = 3), built on load and kept
+    // current by setTile so lookups never scan the grid
+    std::vector<sf::Vector2i> spawnTiles;
+    std::vector<sf::Vector2i> baseTiles;
+    void rebuildIndex();
+    static void unindex(std::vector<sf::Vector2i>& list, int tx, int ty);
+
+    // Rendering: the grid is cut into ChunkSize x ChunkSize chunks that cache
+    // their quads, one list per tile texture plus one for plain colors.
+    // setTile only marks its chunk stale; draw rebuilds the stale chunks in
+    // view. Chunks out of view are dropped once more than MaxCachedChunks are
+    // built. Zoomed out below OverviewPixels per tile, the whole map is one
+    // texture with a pixel per tile, which re-uploads only its dirty rect.
+    static constexpr int ChunkSize = 32;
+    static constexpr int MaxCachedChunks = 256;
+    static constexpr float OverviewPixels = 6.f;
+    enum Layer { Grass, Paving, Stone, Plain, LayerCount };
+    struct Chunk {
+        std::vector<sf::Vertex> layers[LayerCount];
+        bool stale = true;
+        bool built = false;
+        unsigned lastDrawn = 0;
+    };
+    std::vector<Chunk> chunks;
+    int chunkCols = 0, chunkRows = 0;
+    int builtChunks = 0;
+    unsigned drawCount = 0;
+    sf::Texture overview;
+    sf::Sprite overviewSprite;
+    bool overviewReady = false, overviewFailed = false;
+    int dirtyX0 = 0, dirtyY0 = 0, dirtyX1 = -1, dirtyY1 = -1; // overview, inclusive
+    std::vector<sf::Uint8> overviewPixels;
+    void resetRenderCache();
+    void markDirty(int tx, int ty);
+    void markAllDirty();
+    const sf::Texture* layerTexture(int layer) const;
+    void buildChunk(int cx, int cy);
+    void dropHiddenChunks();
+    bool drawOverview(sf::RenderWindow& window);
 public:
     Map(float tileSize = 32.f);
     Map(int cols, int rows, float tileSize);
-    bool loadFromFile(const std::string& filename);
-    // loads tile textures from assets
-    void loadTileTextures();
+    // withTextures = false only replaces the tiles (hot reload keeps the textures);
+    // false, with an empty map, when a row is not as long as the first one
+    bool loadFromFile(const std::string& filename, bool withTextures = true);
+    bool loadFromString(const std::string& text, bool withTextures = true);
+    bool loadFromStream(std::istream& in, bool withTextures = true);
+    // loads tile textures from the asset pack, or from assets/ when fromFiles
+    // is set (hot reload) or the pack lacks them
+    void loadTileTextures(bool fromFiles = false);
     bool saveToFile(const std::string& filename) ;
     void setTile(int tx, int ty, int value);
     int getTile(int tx, int ty) const;
@@ -29,11 +74,10 @@ public:
     void draw(sf::RenderWindow& window);
     int getCols() const { return cols; }
     int getRows() const { return rows; }
-    std::pair<int,int> findBase() const;
-
-
-
-
+    std::pair<int,int> findBase() const;   // first base tile or {-1,-1}, O(1)
+    std::pair<int,int> findSpawn() const;  // first spawn tile or {-1,-1}, O(1)
+    const std::vector<sf::Vector2i>& getSpawns() const { return spawnTiles; }
+    const std::vector<sf::Vector2i>& getBases() const { return baseTiles; }
 };
 
 #endif /* MAP_HPP */
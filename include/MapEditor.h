@@ -0,0 +1,67 @@
+#ifndef MAPEDITOR_HPP
+#define MAPEDITOR_HPP
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+class Game; // forward
+
+// In-game map editor (E). The match is paused while it is open. Strokes paint
+// straight into the Map: setTile keeps the spawn/base index current and marks
+// the render chunk stale. The tiles painted during a frame are then handed to
+// Game::applyTileEdits() once, which repairs the distance field for those
+// tiles only (one hierarchy commit on large maps), along with the heavy and
+// flyer fields if they are in use. Connectivity is checked
+// right after, by reading the field at each spawn. Placement validity is the
+// only full-map pass left, and it runs once, when the editor closes.
+//
+// Off in co-op: the peer would need the edits too.
+class MapEditor {
+public:
+    explicit MapEditor(Game& game) : game(game) {}
+
+    bool isActive() const { return active; }
+    void open();
+    void close();
+    // true if the editor used the event (the game must not handle it too)
+    bool handleEvent(const sf::Event& ev);
+    // once per frame: applies what was painted since the last call; true if anything was
+    bool flush();
+    // brush outline and spawns cut off from every base (world view)
+    void draw(sf::RenderTarget& target);
+
+    int getBrush() const { return brush; }
+    int getRadius() const { return brush >= 3 ? 0 : radius; } // spawns and bases are single tiles
+    // every spawn reaches a base, and there is at least one of each
+    bool isValid() const;
+    int getCutSpawns() const { return static_cast<int>(cutSpawns.size()); }
+    const std::string& getStatus() const { return status; }
+    // bumped whenever something the UI shows changes
+    int getRevision() const { return revision; }
+
+private:
+    Game& game;
+    bool active = false;
+    bool wasPaused = false;
+    bool edited = false;          // tiles changed since open()
+    int brush = 1;                // tile value painted by the left button (0-4)
+    int radius = 0;               // in tiles
+    int strokeValue = -1;         // tile value of the stroke in progress, -1 = none
+    sf::Vector2i lastTile{-1, -1};
+    sf::Vector2f mouse;
+    std::vector<sf::Vector2i> painted; // since the last flush
+    std::vector<sf::Vector2i> cutSpawns;
+    std::string status;
+    int revision = 0;
+    sf::CircleShape brushShape;
+    sf::RectangleShape marker;
+
+    sf::Vector2i tileAt(const sf::Vector2f& world) const;
+    void paintLine(sf::Vector2i from, sf::Vector2i to);
+    void paintAt(int tx, int ty);
+    void validate();
+    void save();
+};
+
+#endif /* MAPEDITOR_HPP */
@@ -0,0 +1,63 @@
+#ifndef PARTICLESYSTEM_HPP
+#define PARTICLESYSTEM_HPP
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+
+// Purely visual particles (explosions, fire, kills, leaks). Storage is one
+// flat array per field sized once by init(), so emitting and updating never
+// allocate; the update is a straight loop over those arrays that the compiler
+// vectorizes (see CMakeLists.txt), then dead particles are compacted out in
+// order. Everything is drawn as one additive batch of quads.
+// Emissions past the budget are dropped (counted, not an error): effects
+// thin out under load instead of costing more. Uses its own rng, so effects
+// never disturb the simulation's random sequence.
+class ParticleSystem {
+public:
+    // capacity is fixed for the lifetime of the system; 0 disables it
+    void init(int capacity);
+    // live particles allowed, <= capacity (the quality governor lowers it)
+    void setBudget(int n);
+    int getBudget() const { return budget; }
+    int getCapacity() const { return capacity; }
+    int getCount() const { return count; }
+    // particles not emitted because of the budget, since init()
+    std::uint64_t getDropped() const { return dropped; }
+
+    void update(float dt);
+    // culls against the visible world rect
+    void draw(sf::RenderTarget& target, const sf::FloatRect& visible);
+    void clear() { count = 0; }
+
+    struct Burst {
+        int count = 16;
+        float speedMin = 20.f, speedMax = 80.f; // px/s, random direction
+        float lifeMin = 0.3f, lifeMax = 0.6f;
+        float sizeMin = 2.f, sizeMax = 4.f;     // half extent of the quad
+        float spread = 0.f;                      // random offset from the origin
+        float drag = 3.f;                        // 1/s
+        float accelY = 0.f;                      // px/s^2, negative rises
+        sf::Color colorA, colorB;                // each particle picks between them
+    };
+    void emit(const sf::Vector2f& at, const Burst& b);
+
+    // presets used by the game
+    void explosion(const sf::Vector2f& at, float radius);
+    void fireTrail(const sf::Vector2f& at);
+    void fireHit(const sf::Vector2f& at);
+    void kill(const sf::Vector2f& at, const sf::Color& color);
+    void leak(const sf::Vector2f& at);
+
+private:
+    int capacity = 0, budget = 0, count = 0;
+    std::uint64_t dropped = 0;
+    std::vector<float> px, py, vx, vy, ay, drag, life, invLife, size;
+    std::vector<std::uint32_t> color; // RGBA, alpha fades with life
+    std::vector<sf::Vertex> vertices; // 4 per particle
+    std::uint32_t seed = 0x9e3779b9u;
+
+    float random01();
+};
+
+#endif /* PARTICLESYSTEM_HPP */
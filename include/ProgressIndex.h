@@ -0,0 +1,48 @@
+#ifndef PROGRESSINDEX_HPP
+#define PROGRESSINDEX_HPP
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <cstddef>
+
+class Enemy; // forward
+
+// Live enemies ordered by how far they still have to go (Enemy::getProgress(),
+// smallest first = closest to a base). Game refreshes it once per tick: keys are
+// recomputed, dead or recycled enemies dropped, and the order restored with an
+// insertion sort, which costs about one pass since enemies rarely overtake each
+// other. When many keys moved at once (a tower changed the field) a radix sort
+// takes over instead. First/Last towers then binary search the key range their
+// tiles can produce instead of scanning every enemy.
+class ProgressIndex {
+public:
+    // no path to a base: kept after every ranked entry
+    static constexpr float Unranked = std::numeric_limits<float>::max();
+    struct Entry {
+        float key;
+        Enemy* enemy;
+        std::uint32_t serial; // Enemy::getSerial() when added
+    };
+
+    void reserve(std::size_t n) { entries.reserve(n); scratch.reserve(n); }
+    void clear() { entries.clear(); }
+    // a newly spawned enemy, sorted in by the next refresh()
+    void add(Enemy* e);
+    void refresh();
+
+    std::size_t size() const { return entries.size(); }
+    const Entry& operator[](std::size_t i) const { return entries[i]; }
+    // first entry with key >= k / > k
+    std::size_t lowerBound(float k) const;
+    std::size_t upperBound(float k) const;
+    // entries from here on have no path (key == Unranked)
+    std::size_t rankedEnd() const { return lowerBound(Unranked); }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch; // radix sort buffer
+    void radixSort();
+};
+
+#endif /* PROGRESSINDEX_HPP */
@@ -15,6 +15,12 @@ public:
     bool dead = false;
     Game* game = nullptr;
     int projType = 0; // 0=default, 1=fire arrow, 2=big sniper ball
+    // visual-only projectiles carry no collision: their damage is a scheduled hit
+    bool visualOnly = false;
+    float lifeTime = 0.f; // seconds until the visual reaches its intercept point
+    float maxTravel = 0.f; // culled after this distance (0 = only at the map bounds)
+    float traveled = 0.f;
+    int towerId = -1;      // firing tower, credited for kills
     Projectile(sf::Vector2f p, sf::Vector2f d, float s, float dmg, Game* g = nullptr, int type = 0);
 
     void update(float dt) override;
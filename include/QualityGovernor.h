@@ -0,0 +1,58 @@
+#ifndef QUALITYGOVERNOR_HPP
+#define QUALITYGOVERNOR_HPP
+#pragma once
+
+// Picks a detail level from how long frames take to draw (particles and
+// rendering; not the simulation, which detail cannot speed up, nor the
+// present, which blocks until vblank with vsync on). When the rolling average goes over the
+// frame budget, detail steps down one level at a time, waiting a moment
+// after each step for the average to reflect it. It steps
+// back up only after a longer stretch well under budget; if a step up has to be
+// undone right away, the next attempt waits twice as long, so a level that
+// just doesn't fit does not flicker.
+//
+//   level 0: everything
+//   level 1: lighter portals, half the particles
+//   level 2: bare portals, range rings only under the mouse, 1/5 of the particles
+//   level 3: enemies as plain shapes instead of sprites, few particles
+class QualityGovernor {
+public:
+    static constexpr int MaxLevel = 3;
+
+    void setBudget(float seconds) { budget = seconds; }
+    float getBudget() const { return budget; }
+    // enabled = false pins level 0
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled; }
+
+    // one sample per rendered frame; returns true when the level changed
+    bool frame(float workSeconds);
+    void reset();
+
+    int getLevel() const { return level; }
+    float getAverage() const { return average; }
+
+    // what each level keeps
+    int portalRings() const { return level == 0 ? 6 : level == 1 ? 3 : level == 2 ? 2 : 1; }
+    int portalArms() const { return level == 0 ? 7 : level == 1 ? 3 : 0; }
+    bool rangeRingsOnHoverOnly() const { return level >= 2; }
+    bool cheapEnemies() const { return level >= 3; }
+    float particleShare() const { return level == 0 ? 1.f : level == 1 ? 0.5f : level == 2 ? 0.2f : 0.05f; }
+
+private:
+    static constexpr int Window = 30; // frames in the rolling average
+    float samples[Window] = {};
+    int sampleCount = 0, sampleHead = 0;
+    float sum = 0.f;
+    float average = 0.f;
+
+    float budget = 1.f / 60.f;
+    bool enabled = true;
+    int level = 0;
+    float sinceChange = 0.f;   // seconds at the current level
+    float underFor = 0.f;      // seconds spent well under budget
+    float upWait = 3.f;        // seconds under budget needed to step up
+    bool steppedUp = false;    // the last change was a step up
+};
+
+#endif /* QUALITYGOVERNOR_HPP */
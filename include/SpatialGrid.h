@@ -0,0 +1,69 @@
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class Enemy;
+
+// Uniform grid over the map (one cell per tile) bucketing the live enemies.
+// Rebuilt once per tick with a counting sort into flat arrays (no per-cell
+// vectors), positions and radii are copied alongside so queries stay in cache.
+// Only the occupied cells are touched, so a tick costs O(enemies), not O(cells).
+class SpatialGrid {
+public:
+    void init(int cols, int rows, float cellSize);
+    void rebuild(const std::vector<std::shared_ptr<Enemy>>& enemies);
+    // room for n enemies, so rebuilds up to that count never allocate
+    void reserve(size_t n);
+
+    // earliest enemy hit by a circle of 'radius' swept from a to b, found by
+    // walking the cells the segment traverses (DDA); returns an index into the
+    // enemies vector given to rebuild(), or -1. 'tHit' receives the hit fraction.
+    // Enemies killed since rebuild() (earlier shots of the same tick) are skipped.
+    int sweepFirst(const sf::Vector2f& a, const sf::Vector2f& b, float radius, float& tHit);
+
+    // crowd separation: every live item overlapping a neighbor closer than
+    // (ri + rj) * spacing gets half the overlap as a push away from it. Only
+    // the 3x3 cells around an item are read (needs maxRadius * 2 * spacing <=
+    // cellSize); each row of 3 cells is one contiguous span of the sorted
+    // arrays, so the inner loop is branch-free and vectorizes (the sums need
+    // float reassociation, see CMakeLists.txt).
+    // pushX/pushY are indexed like the enemies given to rebuild()
+    void separation(float spacing, std::vector<float>& pushX, std::vector<float>& pushY) const;
+    // move an item after rebuild() without changing its cell
+    void setPosition(int item, float x, float y);
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getCellSize() const { return cellSize; }
+    int cellX(float x) const;
+    int cellY(float y) const;
+    // items of one cell: indices [cellBegin, cellEnd) into items()
+    int cellBegin(int cx, int cy) const { return cellStop[cy * cols + cx] - cellCount[cy * cols + cx]; }
+    int cellEnd(int cx, int cy) const { return cellStop[cy * cols + cx]; }
+    const std::vector<int>& items() const { return cellItems; }
+    const std::vector<float>& posX() const { return itemX; }
+    const std::vector<float>& posY() const { return itemY; }
+    float getMaxRadius() const { return maxRadius; }
+
+private:
+    int cols = 0, rows = 0;
+    float cellSize = 32.f;
+    std::vector<int> cellCount;   // items per cell, 0 outside 'occupied'
+    std::vector<int> cellStop;    // end of each occupied cell in cellItems (stale when empty)
+    std::vector<int> occupied;    // cells holding items, ascending; reset by the next rebuild
+    std::vector<int> cellItems;   // enemy indices sorted by cell
+    std::vector<int> itemCell;    // cell of each enemy (rebuild scratch)
+    std::vector<float> itemX, itemY, itemR; // per enemy index, dead ones have r < 0
+    std::vector<float> sortX, sortY, sortR; // same, in cellItems order
+    std::vector<int> itemSlot;              // enemy index -> position in cellItems
+    float maxRadius = 0.f;
+    const std::vector<std::shared_ptr<Enemy>>* source = nullptr; // the vector given to rebuild()
+    std::vector<std::uint32_t> cellStamp; // dedupes cells within one sweep
+    std::uint32_t stamp = 0;
+};
+
+#endif /* SPATIALGRID_HPP */
@@ -0,0 +1,72 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timer wheel (4 levels x 64 slots, in fixed ticks).
+// Timers sit in a slot until their level's slot comes around, then cascade
+// down one level; a tick only touches the timers stored in the current slot,
+// so a timer that fires in 500 ticks costs nothing on the 499 ticks before.
+class TimerWheel {
+public:
+    using TimerId = std::uint64_t;              // slot index + generation, 0 = none
+    static constexpr TimerId InvalidTimer = 0;
+
+    explicit TimerWheel(float tickSeconds = 1.f / 60.f);
+
+    // schedule a callback 'delay' seconds from now (rounded up to whole ticks, at least one)
+    TimerId schedule(float delay, std::function<void()> callback);
+    TimerId scheduleTicks(std::uint64_t ticks, std::function<void()> callback);
+    // cancel a pending timer; stale or already fired ids are ignored
+    void cancel(TimerId id);
+    bool isPending(TimerId id) const;
+    // drop every pending timer and restart the clock at tick 0
+    void clear();
+    // room for n pending timers, so scheduling below that never allocates
+    void reserve(size_t n);
+
+    // advance simulated time; fires every timer that comes due, in tick order
+    void advance(float dt);
+    // advance exactly one tick
+    void tick();
+
+    std::uint64_t now() const { return currentTick; }
+    float nowSeconds() const { return currentTick * tickSeconds; }
+    float getTickSeconds() const { return tickSeconds; }
+    size_t pendingCount() const { return pending; }
+
+private:
+    static constexpr int LevelBits = 6;
+    static constexpr int SlotsPerLevel = 1 << LevelBits;
+    static constexpr int Levels = 4;
+    static constexpr std::uint32_t NoNode = 0xFFFFFFFFu;
+
+    struct Node {
+        std::uint64_t expire = 0;
+        std::uint32_t next = NoNode;
+        std::uint32_t prev = NoNode;
+        std::uint32_t generation = 1;
+        int list = -1;                   // slot list holding the node, -1 when free
+        std::function<void()> callback;
+    };
+
+    float tickSeconds;
+    float accumulator = 0.f;
+    std::uint64_t currentTick = 0;
+    size_t pending = 0;
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> freeNodes;
+    // Levels * SlotsPerLevel slot lists, plus one overflow list for far timers
+    std::vector<std::uint32_t> heads;
+    std::vector<std::uint32_t> firing; // scratch list reused by tick()
+
+    int overflowList() const { return Levels * SlotsPerLevel; }
+    void insert(std::uint32_t idx);
+    void unlink(std::uint32_t idx);
+    void cascade(int list);
+    void release(std::uint32_t idx);
+};
+
+#endif /* TIMERWHEEL_HPP */
@@ -4,11 +4,18 @@
 #include <SFML/Graphics.hpp>
 #include <memory>
 #include <cmath>
+#include <cstdint>
 #include "ElementGraphique.h"
+#include "TimerWheel.h"
 
 class Enemy; // forward
 class Game;  // forward
 
+// which enemy in range a tower picks
+enum class TargetPolicy : std::uint8_t { Closest, First, Last, Strongest, Weakest };
+constexpr int TargetPolicyCount = 5;
+const char* targetPolicyName(TargetPolicy p);
+
 class Tower : public ElementGraphique {
 protected:
     sf::Vector2f pos;
@@ -19,32 +26,63 @@ protected:
     float range = 160.f;
     float damage = 20.f;
     float fireRate = 1.f;
-    float cooldown = 0.f;
+    bool reloading = false;  // cleared by a timer after 1/fireRate seconds
+    TimerWheel::TimerId reloadTimer = TimerWheel::InvalidTimer;
     float rotationSpeed = 3.14f; // rad/s
     float angle = 0.f;
     int level = 1;
     int cost = 60;
     int upgradeCost = 80;
+    int upgradesPaid = 0;  // money put into upgrades so far
+    int id = -1;     // assigned by Game when the tower is placed
+    int kills = 0;
     std::weak_ptr<Enemy> currentTarget;
+    std::uint32_t targetSerial = 0; // Enemy::getSerial() when it was picked
+    TargetPolicy policy = TargetPolicy::Closest;
+    // progress keys an enemy within range can have (see ProgressIndex), from
+    // the field values of the tiles the range touches; recomputed only when
+    // the fields, the live move classes or the range change
+    float bandLo = 0.f, bandHi = -1.f;
+    std::uint64_t bandStamp = ~0ull;
+    void updateBand(const Game& game);
+
+    void drawRange(sf::RenderWindow& window, const sf::Color& color) const; // honours showRange
 
 public:
     Tower(const sf::Vector2f& position, int c = 60, Game* game = nullptr);
+    ~Tower() override;
     void update(float dt) override;  // calls update(dt, *gamePtr) if gamePtr available
     void update(float dt, Game& game);  // actual implementation
     virtual void render(sf::RenderWindow& window) override;
     sf::Vector2f getPosition() const override;
+    bool showRange = true; // set by Game before render (quality level, hover)
     
     // Tower methods
+    // first/last are served from Game::progress (a binary search to the band,
+    // then a walk), closest/strongest/weakest from the enemy grid
     std::shared_ptr<Enemy> findTarget(const Game& game) const;
     bool isValidTarget(const std::shared_ptr<Enemy>& e, const Game& game) const;
     bool updateAngle(float dt, const Game& game);
     virtual void shoot(Game& game);  // Made virtual for subclass override
-    void upgrade();
+    void upgrade();  // Game charges getUpgradeCost() first
+    void startCooldown(Game& game);  // called after each shot
     
     // Getters
     int getCost() const { return cost; }
+    int getUpgradeCost() const { return upgradeCost; }
+    // refund when sold: 70% of everything paid for it
+    int getSellValue() const { return (cost + upgradesPaid) * 7 / 10; }
+    int getLevel() const { return level; }
     float getRange() const { return range; }
     float getDamage() const { return damage; }
+    float getFireRate() const { return fireRate; }
+    float getDps() const { return damage * fireRate; }
+    int getId() const { return id; }
+    void setId(int i) { id = i; }
+    int getKills() const { return kills; }
+    TargetPolicy getPolicy() const { return policy; }
+    void setPolicy(TargetPolicy p) { policy = p; currentTarget.reset(); }
+    void addKill() { kills++; }
 };
 
 #endif /* TOWER_HPP */
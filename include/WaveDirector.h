@@ -0,0 +1,140 @@
+#ifndef WAVEDIRECTOR_HPP
+#define WAVEDIRECTOR_HPP
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "WaveScript.h"
+
+class Game; // forward
+
+// Runs the wave script. A match is one coroutine that walks the blocks wave
+// after wave, and every spawn burst is a coroutine of its own; they co_await
+// delays (TimerWheel timers that resume them), other bursts, and conditions
+// (the field cleared: Game reports deaths, nothing polls). Between two
+// events no coroutine runs and nothing is checked per tick.
+//
+// Coroutine frames come from a fixed pool of blocks, so a wave starting mid
+// match allocates nothing (frames too big for a block, or past the pool,
+// fall back to the heap).
+class WaveDirector {
+public:
+    class Task;
+
+    explicit WaveDirector(Game& game);
+    ~WaveDirector();
+    WaveDirector(const WaveDirector&) = delete;
+    WaveDirector& operator=(const WaveDirector&) = delete;
+
+    // applied when the next wave starts (right away if no match runs)
+    void setScript(const WaveScript& script);
+    const WaveScript& getScript() const { return script; }
+
+    // new match: wave 0 starts now. Pending timers must have been cleared
+    // (TimerWheel::clear) since they could resume a destroyed coroutine
+    void start();
+    void stop();
+    // Game: an enemy died; resumes "wait clear" once the field is empty
+    void fieldChanged();
+    bool isSpawning() const { return activeBursts > 0; }
+
+    class Task {
+    public:
+        struct promise_type {
+            std::coroutine_handle<> continuation; // resumed when this one ends
+            WaveDirector* detachedFrom = nullptr; // async burst: freed when it ends
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            struct Final {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+                void await_resume() noexcept {}
+            };
+            Final final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { throw; }
+
+            // frames of the director's coroutines (member functions: the
+            // director is the first argument) come from its pool
+            template <class... Args>
+            static void* operator new(std::size_t n, WaveDirector& d, Args&&...) { return d.allocFrame(n); }
+            static void operator delete(void* p, std::size_t n) { WaveDirector::freeFrame(p, n); }
+        };
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(Handle h) : handle(h) {}
+        Task(Task&& o) noexcept : handle(o.handle) { o.handle = {}; }
+        Task& operator=(Task&& o) noexcept;
+        ~Task() { if (handle) handle.destroy(); }
+
+        // co_await task: runs it until it ends, then goes on
+        bool await_ready() const noexcept { return !handle || handle.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        friend class WaveDirector;
+        Handle handle;
+    };
+
+private:
+    Game& game;
+    WaveScript script;
+    std::optional<WaveScript> pendingScript;
+    Task match;
+    int activeBursts = 0;
+
+    std::vector<Task::Handle> detached; // async bursts still running
+    static constexpr int MaxWaiters = 8;
+    std::coroutine_handle<> clearWaiters[MaxWaiters];
+    int clearWaiterCount = 0;
+    std::coroutine_handle<> spawnedWaiters[MaxWaiters];
+    int spawnedWaiterCount = 0;
+
+    // frame pool: fixed blocks, each starting with the owning director
+    static constexpr std::size_t BlockSize = 1024;
+    static constexpr int BlockCount = 32;
+    static constexpr std::size_t HeaderSize = alignof(std::max_align_t);
+    std::unique_ptr<unsigned char[]> pool;
+    void* freeBlocks[BlockCount];
+    int freeCount = 0;
+    void* allocFrame(std::size_t n);
+    static void freeFrame(void* p, std::size_t n);
+
+    // awaitables
+    struct Delay {
+        WaveDirector& d;
+        float seconds;
+        std::uint64_t ticks; // used when seconds < 0
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept {}
+    };
+    Delay after(float seconds) { return {*this, seconds, 0}; }
+    Delay afterTicks(std::uint64_t ticks) { return {*this, -1.f, ticks}; }
+    struct Condition {
+        WaveDirector& d;
+        bool spawnedOnly; // false: the whole field clear
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept {}
+    };
+    Condition clear() { return {*this, false}; }
+    Condition spawned() { return {*this, true}; }
+    bool isClear() const;
+
+    Task runMatch();
+    Task burst(WaveOp op, int wave);
+    void detach(Task t);
+    void burstFinished();
+};
+
+#endif /* WAVEDIRECTOR_HPP */
@@ -0,0 +1,55 @@
+#ifndef WAVESCRIPT_HPP
+#define WAVESCRIPT_HPP
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+// Wave content, read from assets/waves.txt (see that file for the syntax)
+// and run by WaveDirector. A script is a cooldown plus blocks of operations,
+// each block covering a range of wave numbers.
+
+// a number that may grow with the wave: "3", "0.6", "3+w", "50+10w", "2w"
+struct WaveValue {
+    float base = 0.f, perWave = 0.f;
+    float at(int wave) const { return base + perWave * wave; }
+    int count(int wave) const { return static_cast<int>(std::lround(at(wave))); }
+};
+
+struct WaveOp {
+    enum class Kind : std::uint8_t { Spawn, Wait, WaitClear, WaitSpawned };
+    Kind kind = Kind::Spawn;
+    // Spawn
+    WaveValue count;
+    WaveValue hp{50.f, 10.f};
+    static constexpr int MaxMix = 4;
+    int mixCount = 0;                // types to pick from, by weight
+    int mixType[MaxMix] = {};
+    int mixWeight[MaxMix] = {};
+    int lane = -1;                   // spawn point index, -1 = all of them in turn
+    bool async = false;              // the wave goes on while it spawns
+    // Spawn: seconds between releases; Wait: the delay
+    WaveValue seconds{0.6f, 0.f};
+};
+
+struct WaveBlock {
+    int first = 0, last = -1;        // waves covered, last = -1: no end
+    std::vector<WaveOp> ops;
+};
+
+class WaveScript {
+public:
+    float cooldown = 5.f;            // seconds between a cleared wave and the next
+    std::vector<WaveBlock> blocks;
+
+    // false with a "line N: ..." message on the first bad line; *this is
+    // only replaced by a script that parsed
+    bool parse(const std::string& text, std::string& error);
+    // first block covering the wave, nullptr if none (the wave is empty)
+    const WaveBlock* blockFor(int wave) const;
+    // used when no waves.txt can be found: the same waves as assets/waves.txt
+    static const char* builtIn();
+};
+
+#endif /* WAVESCRIPT_HPP */
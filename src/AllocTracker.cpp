@@ -0,0 +1,122 @@
+#include "AllocTracker.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+// everything lives in static storage: the tracker must never allocate itself
+struct Zone {
+    const char* name = nullptr;
+    AllocTracker::Counts current, last;
+};
+constexpr int MaxDepth = 16;
+
+AllocTracker::Counts currentFrame, previousFrame, allTime;
+Zone zones[AllocTracker::MaxZones];
+int zoneTotal = 0;
+int zoneStack[MaxDepth];
+int depth = 0;
+}
+
+void AllocTracker::beginFrame() {
+    previousFrame = currentFrame;
+    currentFrame = {};
+    for (int i = 0; i < zoneTotal; ++i) {
+        zones[i].last = zones[i].current;
+        zones[i].current = {};
+    }
+}
+
+const AllocTracker::Counts& AllocTracker::frame() { return currentFrame; }
+const AllocTracker::Counts& AllocTracker::lastFrame() { return previousFrame; }
+const AllocTracker::Counts& AllocTracker::total() { return allTime; }
+
+int AllocTracker::zoneIndex(const char* name) {
+    for (int i = 0; i < zoneTotal; ++i) {
+        if (zones[i].name == name) return i;
+    }
+    if (zoneTotal == MaxZones) return -1;
+    zones[zoneTotal].name = name;
+    return zoneTotal++;
+}
+
+int AllocTracker::zoneCount() { return zoneTotal; }
+const char* AllocTracker::zoneName(int zone) { return zones[zone].name; }
+const AllocTracker::Counts& AllocTracker::zoneLastFrame(int zone) { return zones[zone].last; }
+
+void AllocTracker::enterZone(int zone) {
+    // past the max depth (or the zone table) allocations stay with the parent
+    if (depth < MaxDepth) zoneStack[depth] = zone;
+    ++depth;
+}
+
+void AllocTracker::leaveZone() {
+    if (depth > 0) --depth;
+}
+
+void AllocTracker::countAlloc(std::size_t bytes) {
+    currentFrame.allocs++;
+    currentFrame.bytes += bytes;
+    allTime.allocs++;
+    allTime.bytes += bytes;
+    int top = depth < MaxDepth ? depth : MaxDepth;
+    if (top > 0 && zoneStack[top - 1] >= 0) {
+        Counts& z = zones[zoneStack[top - 1]].current;
+        z.allocs++;
+        z.bytes += bytes;
+    }
+}
+
+void AllocTracker::countFree() {
+    currentFrame.frees++;
+    allTime.frees++;
+    int top = depth < MaxDepth ? depth : MaxDepth;
+    if (top > 0 && zoneStack[top - 1] >= 0) zones[zoneStack[top - 1]].current.frees++;
+}
+
+#ifdef TD_TRACK_ALLOCS
+// Replacements for the global allocation functions. The plain and array forms
+// go through malloc/free; aligned ones through aligned_alloc, which glibc
+// also releases with free, so every delete form can share one path.
+static void* trackedAlloc(std::size_t size) {
+    AllocTracker::countAlloc(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+static void* trackedAlignedAlloc(std::size_t size, std::align_val_t al) {
+    AllocTracker::countAlloc(size);
+    std::size_t a = static_cast<std::size_t>(al);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    std::size_t rounded = (size + a - 1) / a * a;
+    if (void* p = std::aligned_alloc(a, rounded ? rounded : a)) return p;
+    throw std::bad_alloc();
+}
+
+static void trackedFree(void* p) noexcept {
+    if (!p) return;
+    AllocTracker::countFree();
+    std::free(p);
+}
+
+void* operator new(std::size_t size) { return trackedAlloc(size); }
+void* operator new[](std::size_t size) { return trackedAlloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return trackedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return trackedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t al) { return trackedAlignedAlloc(size, al); }
+void* operator new[](std::size_t size, std::align_val_t al) { return trackedAlignedAlloc(size, al); }
+
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { trackedFree(p); }
+#endif
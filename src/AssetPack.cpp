@@ -0,0 +1,118 @@
+#include "AssetPack.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef TD_EMBEDDED_ASSETS
+// defined by the generated AssetPackEmbed.S (.incbin of the build's assets.pack)
+extern "C" const unsigned char td_asset_pack[];
+extern "C" const unsigned char td_asset_pack_end[];
+#endif
+
+AssetPack::~AssetPack() {
+#ifdef __unix__
+    if (mapped) munmap(mapped, length);
+#endif
+}
+
+const AssetPack& AssetPack::shared() {
+    static AssetPack pack;
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+#ifdef TD_EMBEDDED_ASSETS
+        pack.openMemory(td_asset_pack, static_cast<size_t>(td_asset_pack_end - td_asset_pack));
+#endif
+        if (!pack.isOpen()) {
+            std::error_code ec;
+            auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+            if (!ec) pack.openFile((exe.parent_path() / "assets.pack").string());
+        }
+        if (!pack.isOpen()) pack.openFile("assets.pack");
+    }
+    return pack;
+}
+
+bool AssetPack::openMemory(const unsigned char* data, size_t size) {
+    if (!data || size < sizeof(PackHeader)) return false;
+    const auto* header = reinterpret_cast<const PackHeader*>(data);
+    if (std::memcmp(header->magic, "TDPK", 4) != 0 || header->version != PackVersion) return false;
+    if (sizeof(PackHeader) + static_cast<size_t>(header->count) * sizeof(PackEntry) > size) return false;
+    base = data;
+    length = size;
+    entries = reinterpret_cast<const PackEntry*>(data + sizeof(PackHeader));
+    count = header->count;
+    return true;
+}
+
+bool AssetPack::openFile(const std::string& path) {
+#ifdef __unix__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return false; }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    if (!openMemory(static_cast<const unsigned char*>(p), static_cast<size_t>(st.st_size))) {
+        munmap(p, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    mapped = p;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+const PackEntry* AssetPack::find(std::string_view name) const {
+    if (!entries) return nullptr;
+    // entries are sorted by name
+    const PackEntry* end = entries + count;
+    const PackEntry* it = std::lower_bound(entries, end, name, [](const PackEntry& e, std::string_view n) {
+        return std::string_view(e.name, strnlen(e.name, sizeof(e.name))) < n;
+    });
+    if (it == end || std::string_view(it->name, strnlen(it->name, sizeof(it->name))) != name) return nullptr;
+    if (it->offset + it->size > length) return nullptr;
+    return it;
+}
+
+bool AssetPack::loadTexture(sf::Texture& texture, std::string_view name) const {
+    const PackEntry* e = find(name);
+    if (!e || e->kind != PackImage || e->size != static_cast<std::uint64_t>(e->width) * e->height * 4) return false;
+    if (!texture.create(e->width, e->height)) return false;
+    texture.update(base + e->offset);
+    return true;
+}
+
+std::uint32_t AssetPack::fileTime(const std::string& path) {
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(path, ec);
+    if (ec) return 0;
+    auto sys = std::chrono::file_clock::to_sys(t);
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count());
+}
+
+bool AssetPack::isOlderThan(const std::string& path, std::string_view name) const {
+    std::uint32_t onDisk = fileTime(path);
+    if (onDisk == 0) return false;
+    const PackEntry* e = find(name);
+    return !e || onDisk > e->mtime;
+}
+
+bool AssetPack::getText(std::string_view name, std::string& out) const {
+    const PackEntry* e = find(name);
+    if (!e || e->kind != PackRaw) return false;
+    out.assign(reinterpret_cast<const char*>(base + e->offset), static_cast<size_t>(e->size));
+    return true;
+}
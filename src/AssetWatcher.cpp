@@ -0,0 +1,66 @@
+#include "AssetWatcher.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+AssetWatcher::~AssetWatcher() {
+    stop();
+}
+
+#ifdef __linux__
+
+bool AssetWatcher::start(const std::string& assetsDir) {
+    stop();
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return false;
+    // editors either rewrite in place (close-write) or save to a temp file and rename (moved-to)
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+    const char* subdirs[] = {"", "sprites/", "tiles/"};
+    for (const char* sub : subdirs) {
+        std::string dir = assetsDir + "/" + sub;
+        int wd = inotify_add_watch(fd, dir.c_str(), mask);
+        if (wd >= 0) watches.push_back({wd, sub});
+    }
+    if (watches.empty()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void AssetWatcher::stop() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    watches.clear();
+}
+
+void AssetWatcher::poll(std::vector<std::string>& changed) {
+    changed.clear();
+    if (fd < 0) return;
+    alignas(inotify_event) char buf[4096];
+    while (true) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) break; // EAGAIN: nothing pending
+        for (char* p = buf; p < buf + len; ) {
+            auto* ev = reinterpret_cast<inotify_event*>(p);
+            p += sizeof(inotify_event) + ev->len;
+            if (ev->len == 0 || (ev->mask & IN_ISDIR)) continue;
+            auto w = std::find_if(watches.begin(), watches.end(), [&](const Watch& x) { return x.wd == ev->wd; });
+            if (w == watches.end()) continue;
+            std::string rel = w->prefix + ev->name;
+            // a save often produces several events for the same file
+            if (std::find(changed.begin(), changed.end(), rel) == changed.end()) changed.push_back(rel);
+        }
+    }
+}
+
+#else
+
+bool AssetWatcher::start(const std::string&) { return false; }
+void AssetWatcher::stop() {}
+void AssetWatcher::poll(std::vector<std::string>& changed) { changed.clear(); }
+
+#endif
@@ -0,0 +1,140 @@
+#include "BitboardBfs.h"
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TD_BITBFS_AVX2 1
+#endif
+
+// next = (F<<1 | F>>1 | F up | F down) & open & ~visited over words [b, e]
+static void expandRange(const std::uint64_t* F, const std::uint64_t* O, const std::uint64_t* V, std::uint64_t* N, long S, long b, long e) {
+    for (long i = b; i <= e; ++i) {
+        std::uint64_t x = (F[i] << 1) | (F[i - 1] >> 63) | (F[i] >> 1) | (F[i + 1] << 63) | F[i - S] | F[i + S];
+        N[i] = x & O[i] & ~V[i];
+    }
+}
+
+#ifdef TD_BITBFS_AVX2
+// same, four words per step; picked at runtime so the binary still runs without AVX2
+__attribute__((target("avx2")))
+static void expandRangeAvx2(const std::uint64_t* F, const std::uint64_t* O, const std::uint64_t* V, std::uint64_t* N, long S, long b, long e) {
+    long i = b;
+    for (; i + 3 <= e; i += 4) {
+        __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i));
+        __m256i fl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i - 1));
+        __m256i fr = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i + 1));
+        __m256i fu = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i - S));
+        __m256i fd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i + S));
+        __m256i east = _mm256_or_si256(_mm256_slli_epi64(f, 1), _mm256_srli_epi64(fl, 63));
+        __m256i west = _mm256_or_si256(_mm256_srli_epi64(f, 1), _mm256_slli_epi64(fr, 63));
+        __m256i x = _mm256_or_si256(_mm256_or_si256(east, west), _mm256_or_si256(fu, fd));
+        x = _mm256_and_si256(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(O + i)));
+        x = _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(V + i)), x);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(N + i), x);
+    }
+    expandRange(F, O, V, N, S, i, e);
+}
+#endif
+
+void BitboardBfs::resize(int c, int r) {
+    cols = std::max(c, 0);
+    rows = std::max(r, 0);
+    // +1 keeps a padding bit at the end of every row: carries across a row
+    // boundary always land on a bit that open[] keeps clear
+    stride = cols / 64 + 1;
+    size_t total = static_cast<size_t>(rows + 2) * stride;
+    open.resize(total);
+    visited.resize(total);
+    frontier.resize(total);
+    next.resize(total);
+    stamp.resize(total);
+}
+
+void BitboardBfs::search(const std::vector<sf::Vector2i>& sources, std::vector<int>& dist) {
+    dist.assign(static_cast<size_t>(cols) * rows, -1);
+    std::fill(visited.begin(), visited.end(), 0);
+    std::fill(frontier.begin(), frontier.end(), 0);
+    std::fill(stamp.begin(), stamp.end(), 0);
+    active.clear();
+    const long total = static_cast<long>(rows + 2) * stride;
+    long lo = total, hi = -1; // word range holding the frontier
+    for (const auto& s : sources) {
+        if (s.x < 0 || s.y < 0 || s.x >= cols || s.y >= rows) continue;
+        long i = static_cast<long>(s.y + 1) * stride + (s.x >> 6);
+        std::uint64_t bit = std::uint64_t(1) << (s.x & 63);
+        if (!(open[i] & bit)) continue;
+        if (!frontier[i]) active.push_back(i);
+        frontier[i] |= bit;
+        visited[i] |= bit;
+        dist[s.y * cols + s.x] = 0;
+        lo = std::min(lo, i);
+        hi = std::max(hi, i);
+    }
+
+    const std::uint64_t* O = open.data();
+    std::uint64_t* V = visited.data();
+    std::uint64_t* F = frontier.data();
+    std::uint64_t* N = next.data();
+    const long S = stride;
+#ifdef TD_BITBFS_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+#endif
+    // a word of the new layer: mark it visited, give its tiles their distance
+    auto commit = [&](long i, std::uint64_t w, int layer) {
+        F[i] = w;
+        V[i] |= w;
+        active.push_back(i);
+        lo = std::min(lo, i);
+        hi = std::max(hi, i);
+        int y = static_cast<int>(i / S) - 1;
+        int x0 = static_cast<int>(i % S) * 64;
+        int* row = dist.data() + static_cast<size_t>(y) * cols;
+        while (w) {
+            row[x0 + std::countr_zero(w)] = layer;
+            w &= w - 1;
+        }
+    };
+
+    for (std::uint32_t layer = 1; !active.empty(); ++layer) {
+        // the frontier can only grow by one row up or down
+        long b = std::max(lo - S, S);
+        long e = std::min(hi + S, total - S - 1);
+        if (static_cast<long>(active.size()) * 8 >= e - b + 1) {
+            // dense frontier: one flat pass over the whole word range
+#ifdef TD_BITBFS_AVX2
+            if (hasAvx2) expandRangeAvx2(F, O, V, N, S, b, e);
+            else expandRange(F, O, V, N, S, b, e);
+#else
+            expandRange(F, O, V, N, S, b, e);
+#endif
+            active.clear();
+            lo = total;
+            hi = -1;
+            std::copy(N + b, N + e + 1, F + b);
+            for (long i = b; i <= e; ++i) {
+                if (N[i]) commit(i, N[i], static_cast<int>(layer));
+            }
+        } else {
+            // sparse frontier (corridors, diamond edges): only the words next
+            // to an active one can change
+            candidates.clear();
+            for (long i : active) {
+                const long around[5] = {i - 1, i, i + 1, i - S, i + S};
+                for (long c : around) {
+                    if (c < S || c >= total - S || stamp[c] == layer) continue;
+                    stamp[c] = layer;
+                    candidates.push_back(c);
+                    expandRange(F, O, V, N, S, c, c);
+                }
+            }
+            for (long i : active) F[i] = 0;
+            active.clear();
+            lo = total;
+            hi = -1;
+            for (long c : candidates) {
+                if (N[c]) commit(c, N[c], static_cast<int>(layer));
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "CoverageMap.h"
+#include <algorithm>
+#include <cmath>
+
+void CoverageMap::init(int c, int r, float ts) {
+    cols = std::max(c, 0);
+    rows = std::max(r, 0);
+    tileSize = ts;
+    textureReady = false; // size changed: recreated on the next draw
+    clear();
+}
+
+void CoverageMap::clear() {
+    count.assign(static_cast<size_t>(cols) * rows, 0);
+    dps.assign(static_cast<size_t>(cols) * rows, 0.f);
+    markDirty(0, 0, cols - 1, rows - 1);
+}
+
+void CoverageMap::markDirty(int x0, int y0, int x1, int y1) {
+    if (x1 < x0 || y1 < y0) return;
+    if (dirtyX1 < dirtyX0) {
+        dirtyX0 = x0; dirtyY0 = y0; dirtyX1 = x1; dirtyY1 = y1;
+        return;
+    }
+    dirtyX0 = std::min(dirtyX0, x0);
+    dirtyY0 = std::min(dirtyY0, y0);
+    dirtyX1 = std::max(dirtyX1, x1);
+    dirtyY1 = std::max(dirtyY1, y1);
+}
+
+void CoverageMap::stamp(const sf::Vector2f& c, float range, float towerDps, int sign) {
+    if (cols == 0 || rows == 0) return;
+    int x0 = std::max(0, static_cast<int>((c.x - range) / tileSize));
+    int x1 = std::min(cols - 1, static_cast<int>((c.x + range) / tileSize));
+    int y0 = std::max(0, static_cast<int>((c.y - range) / tileSize));
+    int y1 = std::min(rows - 1, static_cast<int>((c.y + range) / tileSize));
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            float dx = (x + 0.5f) * tileSize - c.x, dy = (y + 0.5f) * tileSize - c.y;
+            if (dx * dx + dy * dy > range * range) continue;
+            int i = y * cols + x;
+            if (sign > 0) {
+                count[i]++;
+                dps[i] += towerDps;
+            } else if (count[i] > 0) {
+                // the last tower out leaves an exact zero, not float residue
+                dps[i] = --count[i] ? std::max(0.f, dps[i] - towerDps) : 0.f;
+            }
+        }
+    }
+    markDirty(x0, y0, x1, y1);
+}
+
+void CoverageMap::write(std::ostream& out) const {
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            if (x) out << ',';
+            out << count[y * cols + x] << ':' << dps[y * cols + x];
+        }
+        out << '\n';
+    }
+}
+
+void CoverageMap::draw(sf::RenderTarget& target) {
+    if (cols == 0 || rows == 0) return;
+    if (!textureReady) {
+        if (!texture.create(cols, rows)) return;
+        texture.setSmooth(false);
+        sprite.setTexture(texture, true);
+        sprite.setScale(tileSize, tileSize);
+        textureReady = true;
+        markDirty(0, 0, cols - 1, rows - 1);
+    }
+    if (dirtyX1 >= dirtyX0) {
+        int w = dirtyX1 - dirtyX0 + 1, h = dirtyY1 - dirtyY0 + 1;
+        pixels.resize(static_cast<size_t>(w) * h * 4);
+        sf::Uint8* p = pixels.data();
+        for (int y = dirtyY0; y <= dirtyY1; ++y) {
+            for (int x = dirtyX0; x <= dirtyX1; ++x, p += 4) {
+                int i = y * cols + x;
+                // blue (one tower, weak) to red (heavy fire); untouched tiles stay clear
+                float t = std::min(1.f, dps[i] / fullDps);
+                p[0] = static_cast<sf::Uint8>(40 + 215 * t);
+                p[1] = static_cast<sf::Uint8>(80 + 100 * (1.f - std::abs(2.f * t - 1.f)));
+                p[2] = static_cast<sf::Uint8>(255 * (1.f - t));
+                p[3] = count[i] ? static_cast<sf::Uint8>(std::min(170, 60 + 25 * count[i])) : 0;
+            }
+        }
+        texture.update(pixels.data(), w, h, dirtyX0, dirtyY0);
+        dirtyX1 = dirtyX0 - 1;
+    }
+    target.draw(sprite);
+}
@@ -2,9 +2,26 @@
 #include "Game.h"
 #include <cmath>
 #include <algorithm>
-#include <random>
 
-Enemy::Enemy(const sf::Vector2f& start, Game* gamePtr, float initialHP, int t) : game(gamePtr), hp(initialHP), type(t) {
+Enemy::Enemy(const sf::Vector2f& start, Game* gamePtr, float initialHP, int t) : game(gamePtr) {
+    shape.setOutlineColor(sf::Color::Black);
+    shape.setOutlineThickness(1.f);
+    reset(start, initialHP, t);
+}
+
+void Enemy::reset(const sf::Vector2f& start, float initialHP, int t) {
+    hp = initialHP;
+    type = t;
+    moveClass = moveClassOf(t);
+    alive = true;
+    serial++;
+    status = 0;
+    burnTimer = 0.f; burnDps = 0.f; burnTowerId = -1;
+    stunTimer = 0.f;
+    path.clear();
+    pathIndex = 0;
+    prevTx = prevTy = -1;
+    sprite = sf::Sprite();
     // size the enemy visually relative to tileSize when game/map is available
     if (game) {
         const Map& m = game->getMap();
@@ -36,12 +53,7 @@ Enemy::Enemy(const sf::Vector2f& start, Game* gamePtr, float initialHP, int t) :
         shape.setOrigin(10.f, 10.f);
         shape.setPosition(start);
     }
-    shape.setFillColor(sf::Color(200,50,50));
-    shape.setOutlineColor(sf::Color::Black);
-    shape.setOutlineThickness(1.f);
-    // seed RNG
-    std::random_device rd;
-    rng.seed(rd());
+    shape.setFillColor(fillColorOf(type));
 
     // if game provided, compute starting tile coords and set initial target
     if (game) {
@@ -70,7 +82,12 @@ void Enemy::snapToTileCenter() {
 
 void Enemy::update(float dt) {
     if (!alive) return;
-    
+    if (status) {
+        updateStatus(dt);
+        if (!alive) return; // burned to death
+        if (status & StatusStun) return;
+    }
+
     // If following an explicit path, prefer that
     if (!path.empty() && pathIndex < path.size()) {
         sf::Vector2f pos = shape.getPosition();
@@ -88,73 +105,206 @@ void Enemy::update(float dt) {
     }
 
     // If we have a Game pointer, use BFS distance map to move toward base
-    if (game) {
+    if (game && game->hasDistanceField()) {
+        sf::Vector2f pos = shape.getPosition();
+        if (!stepAlongField(pos, currentSpeed(pos) * dt)) {
+            // reached base
+            alive = false;
+            game->reportDeath(Game::DeathCause::Leaked, -1, type, pos);
+            return;
+        }
+        shape.setPosition(pos);
+        if (sprite.getTexture()) sprite.setPosition(pos);
         const Map& m = game->getMap();
-        const auto& distMap = game->getDistance();
-        if (!distMap.empty()) {
-            float ts = m.getTileSize();
-            int curTx = static_cast<int>(shape.getPosition().x / ts);
-            int curTy = static_cast<int>(shape.getPosition().y / ts);
-            curTx = std::clamp(curTx, 0, m.getCols()-1);
-            curTy = std::clamp(curTy, 0, m.getRows()-1);
-
-            // Debug info: print current tile and distance
-            // debug print removed
-            // Check if reached base
-            if (m.getTile(curTx, curTy) == 3) {
-                alive = false;
-                return;
-            }
+        float ts = m.getTileSize();
+        tx = std::clamp(static_cast<int>(pos.x / ts), 0, m.getCols()-1);
+        ty = std::clamp(static_cast<int>(pos.y / ts), 0, m.getRows()-1);
+        if (tx != prevTx || ty != prevTy) {
+            prevTx = tx; prevTy = ty;
+        }
+        return;
+    }
 
-            int bestX = curTx, bestY = curTy;
-            int bestDist = distMap[curTy][curTx];
-            auto neighbors = game->getNeighborsPublic(curTx, curTy);
-            for (auto n : neighbors) {
-                int nx = n.x, ny = n.y;
-                int d = distMap[ny][nx];
-                if (d != -1 && (bestDist == -1 || d < bestDist)) {
-                    bestDist = d; bestX = nx; bestY = ny;
-                }
-            }
+    // fallback: do nothing (or random-walk if desired)
+}
 
-            // move toward center of best tile
-            sf::Vector2f target = m.tileCenter(bestX, bestY);
-            sf::Vector2f dir = target - shape.getPosition();
-            float dist = std::hypot(dir.x, dir.y);
-                if (dist > 1.f) {
-                    dir /= dist;
-                    shape.move(dir * speed * dt);
-                    if (sprite.getTexture()) sprite.setPosition(shape.getPosition());
-            } else {
-                // reached target tile center: snap and update tx/ty
-                tx = bestX; ty = bestY;
-                snapToTileCenter();
-                if (tx != prevTx || ty != prevTy) {
-                    prevTx = tx; prevTy = ty;
-                }
-            }
-            return;
+int Enemy::nextTile(int curTx, int curTy, int& bestX, int& bestY) const {
+    bestX = curTx; bestY = curTy;
+    int bestDist = game->getDistanceAt(curTx, curTy, moveClass);
+    // tiles this class cannot cross are -1 in its field
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    for (int k = 0; k < 4; ++k) {
+        int nx = curTx + dx[k], ny = curTy + dy[k];
+        int d = game->getDistanceAt(nx, ny, moveClass);
+        if (d != -1 && (bestDist == -1 || d < bestDist)) {
+            bestDist = d; bestX = nx; bestY = ny;
         }
     }
+    return bestDist;
+}
 
-    // fallback: do nothing (or random-walk if desired)
+bool Enemy::stepAlongField(sf::Vector2f& pos, float step) const {
+    const Map& m = game->getMap();
+    float ts = m.getTileSize();
+    int curTx = static_cast<int>(pos.x / ts);
+    int curTy = static_cast<int>(pos.y / ts);
+    curTx = std::clamp(curTx, 0, m.getCols()-1);
+    curTy = std::clamp(curTy, 0, m.getRows()-1);
+
+    // Check if reached base
+    if (m.getTile(curTx, curTy) == 3) return false;
+
+    int bestX, bestY;
+    nextTile(curTx, curTy, bestX, bestY);
+
+    // move toward center of best tile
+    sf::Vector2f target = m.tileCenter(bestX, bestY);
+    sf::Vector2f dir = target - pos;
+    float dist = std::hypot(dir.x, dir.y);
+    if (dist > 1.f) {
+        pos += dir / dist * step;
+    } else {
+        // reached target tile center: snap
+        pos = target;
+    }
+    return true;
+}
+
+float Enemy::getProgress() const {
+    if (!game || !game->hasDistanceField()) return ProgressIndex::Unranked;
+    const Map& m = game->getMap();
+    float ts = m.getTileSize();
+    sf::Vector2f pos = shape.getPosition();
+    int curTx = std::clamp(static_cast<int>(pos.x / ts), 0, m.getCols()-1);
+    int curTy = std::clamp(static_cast<int>(pos.y / ts), 0, m.getRows()-1);
+    int cur = game->getDistanceAt(curTx, curTy, moveClass);
+    int nx, ny;
+    int next = nextTile(curTx, curTy, nx, ny);
+    if (next < 0) return ProgressIndex::Unranked;
+    if (cur < 0) cur = next;
+    // the field value of the tile we head for, plus the part of the step into
+    // it still ahead of us: decreases smoothly as the enemy walks
+    sf::Vector2f d = m.tileCenter(nx, ny) - pos;
+    float ahead = std::min(1.f, std::hypot(d.x, d.y) / ts);
+    return static_cast<float>(next) + static_cast<float>(cur - next) * ahead;
+}
+
+sf::Vector2f Enemy::nudge(const sf::Vector2f& delta) {
+    sf::Vector2f pos = shape.getPosition();
+    if (!game) return pos;
+    const Map& m = game->getMap();
+    float ts = m.getTileSize();
+    sf::Vector2f c = m.tileCenter(tx, ty);
+    float half = ts * 0.35f;
+    // never push further out of the tile core than the field movement already took us
+    auto clampAxis = [half](float p, float d, float center) {
+        float lo = std::min(p, center - half), hi = std::max(p, center + half);
+        return std::clamp(p + d, lo, hi);
+    };
+    pos.x = clampAxis(pos.x, delta.x, c.x);
+    pos.y = clampAxis(pos.y, delta.y, c.y);
+    shape.setPosition(pos);
+    if (sprite.getTexture()) sprite.setPosition(pos);
+    return pos;
+}
+
+sf::Vector2f Enemy::predictPosition(float t) const {
+    sf::Vector2f pos = shape.getPosition();
+    if (!game || !game->hasDistanceField() || t <= 0.f) return pos;
+    // a stunned enemy stays put until the stun wears off
+    if (status & StatusStun) t -= std::min(t, stunTimer);
+    // one straight segment per tile: inside a tile both the heading (center of
+    // the best neighbor, as in stepAlongField) and the speed (slow grid) are
+    // fixed, so we only need where the heading leaves the tile
+    const Map& m = game->getMap();
+    const float ts = m.getTileSize();
+    for (int seg = 0; seg < 256 && t > 0.f; ++seg) {
+        int curTx = std::clamp(static_cast<int>(pos.x / ts), 0, m.getCols()-1);
+        int curTy = std::clamp(static_cast<int>(pos.y / ts), 0, m.getRows()-1);
+        if (m.getTile(curTx, curTy) == 3) break; // would reach the base first
+        int bestX, bestY;
+        nextTile(curTx, curTy, bestX, bestY);
+        sf::Vector2f d = m.tileCenter(bestX, bestY) - pos;
+        float dist = std::hypot(d.x, d.y);
+        float v = currentSpeed(pos);
+        if (dist <= 1.f || v <= 0.f) break; // parked on a tile with no way down
+        d /= dist;
+        float leave = dist;
+        if (d.x > 0.f) leave = std::min(leave, ((curTx + 1) * ts - pos.x) / d.x);
+        else if (d.x < 0.f) leave = std::min(leave, (curTx * ts - pos.x) / d.x);
+        if (d.y > 0.f) leave = std::min(leave, ((curTy + 1) * ts - pos.y) / d.y);
+        else if (d.y < 0.f) leave = std::min(leave, (curTy * ts - pos.y) / d.y);
+        // just across the edge, so the next segment starts in the next tile
+        float s = std::min(dist, std::max(leave, 0.f) + 0.01f);
+        if (s >= v * t) return pos + d * (v * t);
+        pos += d * s;
+        t -= s / v;
+    }
+    return pos;
+}
+
+float Enemy::currentSpeed(const sf::Vector2f& pos) const {
+    if (!game) return speed;
+    // freezing auras are pre-rasterized per tile
+    float ts = game->getMap().getTileSize();
+    return speed * game->getSlowAt(static_cast<int>(pos.x / ts), static_cast<int>(pos.y / ts));
+}
+
+void Enemy::updateStatus(float dt) {
+    if (status & StatusStun) {
+        stunTimer -= dt;
+        if (stunTimer <= 0.f) status &= ~StatusStun;
+    }
+    if (status & StatusBurn) {
+        float step = std::min(dt, burnTimer);
+        burnTimer -= dt;
+        if (burnTimer <= 0.f) status &= ~StatusBurn;
+        takeDamage(burnDps * step, burnTowerId);
+    }
+}
+
+void Enemy::applyBurn(float dps, float duration, int towerId) {
+    burnDps = std::max((status & StatusBurn) ? burnDps : 0.f, dps);
+    burnTimer = std::max((status & StatusBurn) ? burnTimer : 0.f, duration);
+    burnTowerId = towerId;
+    status |= StatusBurn;
+}
+
+void Enemy::applyStun(float duration) {
+    stunTimer = std::max((status & StatusStun) ? stunTimer : 0.f, duration);
+    status |= StatusStun;
 }
 
 void Enemy::render(sf::RenderWindow& window) {
+    if (!alive) return; // compacted out on the next update
+    // tint by the strongest visible status
+    sf::Color tint = sf::Color::White;
+    if (status & StatusStun) tint = sf::Color(160, 160, 160);
+    else if (status & StatusBurn) tint = sf::Color(255, 170, 90);
     if (sprite.getTexture()) {
+        sprite.setColor(tint);
         window.draw(sprite);
     } else {
         window.draw(shape);
     }
 }
 
+void Enemy::renderCheap(sf::RenderWindow& window) {
+    if (alive) window.draw(shape);
+}
+
 sf::Vector2f Enemy::getPosition() const {
     return shape.getPosition();
 }
 
-void Enemy::takeDamage(float dmg) {
+void Enemy::takeDamage(float dmg, int towerId) {
+    if (!alive) return;
     hp -= dmg;
-    if (hp <= 0) alive = false;
+    if (hp <= 0) {
+        alive = false;
+        if (game) game->reportDeath(Game::DeathCause::KilledByTower, towerId, type, getPosition());
+    }
 }
 
 bool Enemy::isAlive() const { 
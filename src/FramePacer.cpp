@@ -0,0 +1,31 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+void FramePacer::setTargetFps(int f) {
+    fps = std::max(f, 0);
+    period = fps > 0 ? sf::microseconds(1000000 / fps) : sf::Time::Zero;
+    reset();
+}
+
+void FramePacer::wait() {
+    if (period == sf::Time::Zero) return;
+    sf::Time now = clock.getElapsedTime();
+    if (next == sf::Time::Zero || now > next + period) {
+        // first frame, or more than a frame behind: start the schedule over
+        // rather than rendering back-to-back frames to catch up
+        next = now;
+    }
+    next += period;
+    sf::Time sleepFor = next - now - margin;
+    if (sleepFor > sf::Time::Zero) {
+        sf::sleep(sleepFor);
+        sf::Time woke = clock.getElapsedTime();
+        sf::Time over = woke - now - sleepFor;
+        // running average of the wake-up lateness, plus some slack
+        sf::Time target = over + sf::microseconds(250);
+        margin = sf::microseconds((margin.asMicroseconds() * 7 + target.asMicroseconds()) / 8);
+        margin = std::clamp(margin, sf::microseconds(200), sf::microseconds(4000));
+    }
+    while (clock.getElapsedTime() < next) std::this_thread::yield();
+}
@@ -4,45 +4,87 @@
 #include "Enemy.h"
 #include "Projectile.h"
 #include "GameUI.h"
-#include <deque>
+#include "AssetPack.h"
+#include "AllocTracker.h"
 #include <filesystem>
 #include <cstdlib>
-#include <ctime>
+#include <random>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <cmath>
 #include <algorithm>
 
-Game::Game() : window(sf::VideoMode(800,600), "TowerDefense - prototype"), map(48.f) {
-    // charge la map depuis le fichier assets/Map.txt si possible
-    // try common relative paths: when running from project root or from build/
-    bool ok = map.loadFromFile("assets/Map.txt");
-    if (!ok) ok = map.loadFromFile("../assets/Map.txt");
+Game::Game(bool headless) : map(48.f), headless(headless) {
+    // charge la map depuis le pack d'assets (embarqué dans l'exécutable),
+    // sinon depuis assets/Map.txt: from project root or from build/
+    // (also when the editor saved it after the pack was built)
+    std::string packedMap;
+    bool ok = !hasNewerFile("Map.txt") && AssetPack::shared().getText("Map.txt", packedMap) && map.loadFromString(packedMap);
+    if (!ok) ok = map.loadFromFile("assets/Map.txt");
+    if (!ok) {
+        ok = map.loadFromFile("../assets/Map.txt");
+        if (ok) assetsDir = "../assets";
+    }
     if (!ok) {
         // fallback : crée une map 16x12 si le chargement échoue
         map = Map(16,12,48.f);
     }
 
-    // now that map is initialized, resize the window to fit the map
-    int width = map.getCols() * static_cast<int>(map.getTileSize());
-    int height = map.getRows() * static_cast<int>(map.getTileSize());
-    if (width > 0 && height > 0) {
-        window.create(sf::VideoMode(width, height), "TowerDefense - prototype");
-    }
+    loadWaveScript();
 
     // initialize tileBlocked grid (no tower blocks at start)
     tileBlocked.assign(map.getRows(), std::vector<bool>(map.getCols(), false));
-
+    enemyGrid.init(map.getCols(), map.getRows(), map.getTileSize());
+    rebuildSlowGrid();
+    rebuildCoverage();
     // compute BFS distance map once for all enemies (must be done after the map is loaded)
     computeBFS();
+    if (headless) return;
+    particles.init(particleCapacity);
+
+    // now that map is initialized, create the window once: it fits the map,
+    // but never exceeds the desktop (larger maps are explored with the camera)
+    int width = map.getCols() * static_cast<int>(map.getTileSize());
+    int height = map.getRows() * static_cast<int>(map.getTileSize());
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    int maxW = std::max(800, static_cast<int>(desktop.width * 0.9f));
+    int maxH = std::max(600, static_cast<int>(desktop.height * 0.85f));
+    if (width <= 0 || height <= 0) { width = 800; height = 600; }
+    window.create(sf::VideoMode(std::min(width, maxW), std::min(height, maxH)), "TowerDefense - prototype");
+    resetCamera();
     
     // Initialize UI
     ui = std::make_unique<GameUI>(this);
-    // seed randomness
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
     
     // load textures (enemy sprites, projectiles)
+    loadTextures();
+    // watch the assets for edits (maps and sprites reload live)
+    // (only when running next to a source tree; the pack covers everything else)
+    if (!assetWatcher.start(assetsDir) && assetWatcher.start("../assets")) assetsDir = "../assets";
+    if (assetWatcher.isRunning()) std::cout << "Watching " << assetsDir << " for changes" << std::endl;
+
+    // Spawn first wave of enemies
+        // show main menu at startup: wait for player to press Start
+        gameStarted = false;
+        // show main menu at startup: wait for player to press Start
+        gameStarted = false;
+}
+
+void Game::loadTextures(bool fromFiles) {
     texturesLoaded = false;
     bool ok1 = false, ok2 = false, ok3 = false;
+    if (!fromFiles) {
+        const AssetPack& pack = AssetPack::shared();
+        ok1 = pack.loadTexture(enemy1Texture, "sprites/ennemie1.png");
+        ok2 = pack.loadTexture(enemy2Texture, "sprites/ennemie2.png");
+        ok3 = pack.loadTexture(fireArrowTexture, "sprites/Fire.png");
+        if (ok1 && ok2 && ok3) {
+            texturesLoaded = true;
+            std::cout << "Loaded sprites from the asset pack" << std::endl;
+            return;
+        }
+    }
     namespace fs = std::filesystem;
     if (fs::exists("assets/sprites/ennemie1.png")) ok1 = enemy1Texture.loadFromFile("assets/sprites/ennemie1.png");
     else if (fs::exists("../assets/sprites/ennemie1.png")) ok1 = enemy1Texture.loadFromFile("../assets/sprites/ennemie1.png");
@@ -55,157 +97,550 @@ Game::Game() : window(sf::VideoMode(800,600), "TowerDefense - prototype"), map(4
     if (ok1) std::cout << "Loaded enemy1 sprite (assets/sprites/ennemie1.png)" << std::endl;
     if (ok2) std::cout << "Loaded enemy2 sprite (assets/sprites/ennemie2.png)" << std::endl;
     if (ok3) std::cout << "Loaded fire sprite (assets/sprites/Fire.png)" << std::endl;
+}
 
-    // Spawn first wave of enemies
-        // show main menu at startup: wait for player to press Start
-        gameStarted = false;
-        // show main menu at startup: wait for player to press Start
-        gameStarted = false;
+bool Game::pollAssetChanges() {
+    assetWatcher.poll(changedAssets);
+    if (changedAssets.empty()) return false;
+    bool spritesChanged = false, tilesChanged = false;
+    for (const auto& rel : changedAssets) {
+        if ((rel == "Map.txt" || rel == "waves.txt") && net) {
+            // only this peer would see the edit: the match would desync
+            std::cout << rel << " changed, not reloaded during co-op" << std::endl;
+            continue;
+        }
+        if (rel == "Map.txt") reloadMap();
+        else if (rel == "waves.txt") loadWaveScript(true);
+        else if (rel.rfind("sprites/", 0) == 0) spritesChanged = true;
+        else if (rel.rfind("tiles/", 0) == 0) tilesChanged = true;
+    }
+    // textures are reloaded in place: sprites already pointing at them follow
+    if (spritesChanged) loadTextures(true);
+    if (tilesChanged) map.loadTileTextures(true);
+    return true;
+}
+
+bool Game::hasNewerFile(const std::string& name) const {
+    const AssetPack& pack = AssetPack::shared();
+    return pack.isOlderThan(assetsDir + "/" + name, name) || pack.isOlderThan("../assets/" + name, name);
+}
+
+void Game::loadWaveScript(bool fromFiles) {
+    std::string text, from = "pack";
+    bool found = !fromFiles && !hasNewerFile("waves.txt") && AssetPack::shared().getText("waves.txt", text);
+    if (!found) {
+        from = assetsDir + "/waves.txt";
+        std::ifstream file(from);
+        if (!file && !fromFiles) file.open(from = "../assets/waves.txt");
+        if (file) {
+            text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            found = true;
+        }
+    }
+    if (!found) return; // the built-in waves stay
+    WaveScript script;
+    std::string error;
+    if (!script.parse(text, error)) {
+        std::cout << "waves.txt (" << from << ") " << error << ", keeping the current waves" << std::endl;
+        return;
+    }
+    waves.setScript(script);
+    if (fromFiles) std::cout << "Reloaded " << from << " (applies from the next wave)" << std::endl;
+}
+
+void Game::reloadMap() {
+    Map fresh(map.getTileSize());
+    if (!fresh.loadFromFile(assetsDir + "/Map.txt", false) || fresh.getCols() <= 0 || fresh.getRows() <= 0) {
+        std::cout << "Map reload failed, keeping the current map" << std::endl;
+        return; // half-written file: wait for the next save
+    }
+    if (fresh.getSpawns().empty() || fresh.getBases().empty()) {
+        // waves would have nowhere to start or nothing to walk to
+        std::cout << "Map reload failed: needs a spawn and a base, keeping the current map" << std::endl;
+        return;
+    }
+    bool resized = fresh.getCols() != map.getCols() || fresh.getRows() != map.getRows();
+    // copy the tiles over, keeping the loaded textures
+    if (resized) {
+        map = Map(fresh.getCols(), fresh.getRows(), map.getTileSize());
+        map.loadTileTextures(true);
+    }
+    std::vector<sf::Vector2i> changed;
+    for (int y = 0; y < fresh.getRows(); ++y) {
+        for (int x = 0; x < fresh.getCols(); ++x) {
+            if (map.getTile(x, y) == fresh.getTile(x, y)) continue;
+            map.setTile(x, y, fresh.getTile(x, y));
+            changed.emplace_back(x, y);
+        }
+    }
+    // the editor just saved it: nothing to recompute
+    if (!resized && changed.empty()) return;
+
+    // towers whose tile disappeared or is no longer buildable are sold
+    if (resized) tileBlocked.assign(map.getRows(), std::vector<bool>(map.getCols(), false));
+    bool towersChanged = false;
+    for (size_t i = 0; i < towers.size();) {
+        sf::Vector2f p = towers[i]->getPosition();
+        int tx = static_cast<int>(p.x / map.getTileSize());
+        int ty = static_cast<int>(p.y / map.getTileSize());
+        int v = map.getTile(tx, ty);
+        bool inside = tx >= 0 && ty >= 0 && tx < map.getCols() && ty < map.getRows();
+        if (!inside || v == 2 || v == 3 || v == 4) {
+            if (inside) changed.emplace_back(tx, ty);
+            // coverage is rebuilt once below instead of unstamped per tower
+            removeTower(towers[i].get());
+            towersChanged = true;
+            continue;
+        }
+        if (resized) tileBlocked[ty][tx] = true;
+        ++i;
+    }
+
+    // only what depends on the tiles is recomputed: the match keeps running
+    if (resized) {
+        enemyGrid.init(map.getCols(), map.getRows(), map.getTileSize());
+        enemyGrid.rebuild(enemies);
+        clampCamera();
+    }
+    if (resized || towersChanged) {
+        rebuildSlowGrid();
+        rebuildCoverage();
+    }
+    if (resized || !useHierarchy || hierarchy.empty()) {
+        computeBFS();
+        if (!spawnPoints.empty()) spawnPoints = map.getSpawns();
+    } else {
+        // large maps: same incremental repair as the editor, only the
+        // clusters holding changed tiles are rebuilt
+        applyTileEdits(changed);
+        rebuildPlacementValidity();
+    }
+    std::cout << "Reloaded " << assetsDir << "/Map.txt" << std::endl;
 }
 
 void Game::startNewGame() {
     // Clear entities
+    progress.clear();
     enemies.clear();
     towers.clear();
     projectiles.clear();
+    towerById.clear();
+    nextTowerId = 0;
+    selectedTowerId = -1;
+    deathEvents.clear();
+    stats = {};
+    liveEnemies = 0;
+    for (auto& f : classFields) f = {};
     // Reset state
     money = startingMoney;
     playerHealth = 20;
     gameOver = false;
     paused = false;
     currentWave = 0;
-    waveTimer = 0.f;
-    spawnQueue.clear();
-    // recompute BFS
+    simTime = 0.f;
+    simTicks = 0;
+    simAccumulator = 0.f;
+    // a match is fully determined by its seed and the player's inputs
+    if (!seedFixed) matchSeed = std::random_device{}();
+    rng.seed(matchSeed);
+    // drop pending reloads, spawns and hits of the previous match, then the
+    // wave coroutines those timers would have resumed
+    timers.clear();
+    waves.stop();
+    scheduledHits.clear();
+    freeHitSlots.clear();
+    spawnPortalPulse = {};
+    basePortalPulse = {};
+    // towers are gone: free their tiles before paths and placement are recomputed
+    tileBlocked.assign(map.getRows(), std::vector<bool>(map.getCols(), false));
+    // recompute BFS and auras
     computeBFS();
-    // start first wave
-    spawnEnemyWave(getWaveEnemyCount(0));
-}
-
-std::vector<sf::Vector2i> Game::getNeighbors(int tx, int ty) const {
-    std::vector<sf::Vector2i> result;
-    const std::pair<int,int> deltas[4] = {{1,0},{-1,0},{0,1},{0,-1}};
-    for (auto d : deltas) {
-        int nx = tx + d.first;
-        int ny = ty + d.second;
-        // check bounds and avoid obstacle tile value 2
-        int val = map.getTile(nx, ny);
-        // getTile returns 0 for out-of-bounds; ensure in-bounds by comparing coords
-        if (nx < 0 || ny < 0 || nx >= map.getCols() || ny >= map.getRows()) continue;
-        if (val == 2) continue; // treat 2 as obstacle
-        // also treat tower blocked tiles as obstacles
-        if (tx >=0 && ty >=0 && tx < (int)map.getCols() && ty < (int)map.getRows()) {
-            if (tileBlocked[ny][nx]) continue;
-        }
-        result.emplace_back(nx, ny);
-    } 
-    return result;
+    rebuildSlowGrid();
+    rebuildCoverage();
+    enemyGrid.rebuild(enemies);
+    // first wave
+    waves.start();
 }
 
-void Game::computeBFS(){
-    auto base = map.findBase();
-    int bx = base.first;
-    int by = base.second;
-    if (bx < 0 || by < 0) return; // no base found
-    distance.assign(map.getRows(), std::vector<int>(map.getCols(), -1));
-    came_from.assign(map.getRows(), std::vector<sf::Vector2i>(map.getCols(), {-1,-1}));
-    std::deque<sf::Vector2i> frontier;
-    frontier.push_back({bx, by});
-    distance[by][bx] = 0;
-    while (!frontier.empty()){
-        sf::Vector2i current = frontier.front();
-        frontier.pop_front();
-        auto neighbors = getNeighbors(current.x, current.y);
-        for (auto n : neighbors){
-            int nx = n.x;
-            int ny = n.y;
-            if (distance[ny][nx] == -1){
-                distance[ny][nx]= distance[current.y][current.x]+1;
-                came_from[ny][nx] = current;
-                frontier.push_back(n);
+int Game::tileCost(MoveClass mc, int tx, int ty) const {
+    int v = map.getTile(tx, ty);
+    switch (mc) {
+        case MoveClass::Flyer:
+            return 1; // over walls and towers alike
+        case MoveClass::Heavy:
+            if (v == 2 || tileBlocked[ty][tx]) return -1;
+            return v == 1 ? 3 : 1; // heavies sink into the paving: go around if cheap
+        case MoveClass::Ground:
+        default:
+            return (v == 2 || tileBlocked[ty][tx]) ? -1 : 1;
+    }
+}
+
+void Game::computeClassField(MoveClass mc) const {
+    // Dijkstra back from every base; leaving a tile costs tileCost of that tile
+    ClassField& f = classFields[static_cast<int>(mc)];
+    const int cols = map.getCols(), rows = map.getRows();
+    f.dist.assign(cols * rows, -1);
+    f.valid = true;
+    // min-heap of (cost, tile) kept in a member so recomputes reuse its storage
+    classHeap.clear();
+    for (const auto& b : map.getBases()) {
+        f.dist[b.y * cols + b.x] = 0;
+        classHeap.push_back({0, b.y * cols + b.x});
+        std::push_heap(classHeap.begin(), classHeap.end(), std::greater<>());
+    }
+    runClassSearch(mc);
+}
+
+void Game::runClassSearch(MoveClass mc) const {
+    ClassField& f = classFields[static_cast<int>(mc)];
+    const int cols = map.getCols(), rows = map.getRows();
+    auto& pq = classHeap;
+    auto push = [&](int d, int i) {
+        pq.push_back({d, i});
+        std::push_heap(pq.begin(), pq.end(), std::greater<>());
+    };
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    while (!pq.empty()) {
+        std::pop_heap(pq.begin(), pq.end(), std::greater<>());
+        auto [d, i] = pq.back();
+        pq.pop_back();
+        if (d != f.dist[i]) continue;
+        int x = i % cols, y = i / cols;
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int c = tileCost(mc, nx, ny);
+            if (c < 0) continue;
+            int ni = ny * cols + nx;
+            if (f.dist[ni] == -1 || d + c < f.dist[ni]) {
+                f.dist[ni] = d + c;
+                push(d + c, ni);
             }
         }
     }
 }
 
-void Game::spawnEnemyWave(int count) {
-    // find spawn tile (value 4)
-    int spawnTx = -1, spawnTy = -1;
-    for (int y = 0; y < map.getRows(); ++y) {
-        for (int x = 0; x < map.getCols(); ++x) {
-            if (map.getTile(x, y) == 4) {
-                spawnTx = x; spawnTy = y;
-                goto found;  // break double loop
-            }
+void Game::repairClassFields(const sf::Vector2i* tiles, int count) {
+    fieldVersion++;
+    for (int c = 0; c < MoveClassCount; ++c) {
+        // ground walks distance/hierarchy; a field nobody uses stays lazy
+        if (static_cast<MoveClass>(c) == MoveClass::Ground || !classFields[c].valid) continue;
+        repairClassField(static_cast<MoveClass>(c), tiles, count);
+    }
+}
+
+void Game::repairClassField(MoveClass mc, const sf::Vector2i* tiles, int count) {
+    // Only the edited tiles whose cost or base status changed for this class
+    // matter (a wall painted under flyers changes nothing). They and every tile
+    // whose way to a base ran through them are reset, then searched again from
+    // their untouched neighbours; the rest of the field keeps its values.
+    ClassField& f = classFields[static_cast<int>(mc)];
+    const int cols = map.getCols(), rows = map.getRows();
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    if (classMark.size() != f.dist.size()) {
+        classMark.assign(f.dist.size(), 0);
+        classMarkStamp = 0;
+    }
+    if (++classMarkStamp == 0) { // wrapped: reset the marks
+        std::fill(classMark.begin(), classMark.end(), 0);
+        classMarkStamp = 1;
+    }
+    // what a tile's value must be given its neighbours' (0 on a base)
+    auto expected = [&](int i) {
+        int x = i % cols, y = i / cols;
+        if (map.getTile(x, y) == 3) return 0;
+        int c = tileCost(mc, x, y);
+        if (c < 0) return -1;
+        int best = -1;
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int d = f.dist[ny * cols + nx];
+            if (d >= 0 && (best < 0 || d < best)) best = d;
         }
+        return best < 0 ? -1 : best + c;
+    };
+    // the field was consistent before the edit: a tile that no longer is changed
+    classReset.clear();
+    for (int k = 0; k < count; ++k) {
+        int i = tiles[k].y * cols + tiles[k].x;
+        if (classMark[i] == classMarkStamp || f.dist[i] == expected(i)) continue;
+        classMark[i] = classMarkStamp;
+        classReset.push_back(i);
     }
-    found:
-    
-    if (spawnTx == -1) {
-        spawnTx = 0; spawnTy = std::min(map.getRows()-1, 6);
-    }
-    spawnTileX = spawnTx;
-    spawnTileY = spawnTy;
-
-    // Instead of spawning all at once, queue them with spawnInterval spacing
-    spawnQueue.clear();
-    spawnTimer = 0.f; // spawn first immediately
-    // set HP for wave (base + wave * scale)
-    float hp = enemyBaseHP + currentWave * enemyHpScale;
-    // store spawn HP for queued spawns
-    nextSpawnHP = hp;
-
-    // Determine enemy type composition: initial waves are enemy1, later waves use enemy2 and mixed waves
-    for (int i = 0; i < count; ++i) {
-        int type = 1; // default enemy1
-        if (currentWave <= 2) {
-            type = 1;
-        } else if (currentWave == 3) {
-            type = 2;
-        } else if (currentWave == 4 || currentWave == 5) {
-            // mostly type2, some type1
-            int r = std::rand() % 100;
-            type = (r < 70) ? 2 : 1; // 70% type2
+    if (classReset.empty()) return;
+    // tiles whose value came from a reset one, transitively (old values)
+    for (size_t q = 0; q < classReset.size(); ++q) {
+        // a base moved across a big basin: resetting and searching again
+        // would cost more than one search over the whole map
+        if (classReset.size() * 4 > f.dist.size()) {
+            computeClassField(mc);
+            return;
+        }
+        int m = classReset[q];
+        if (f.dist[m] < 0) continue;
+        int x = m % cols, y = m / cols;
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int n = ny * cols + nx;
+            if (classMark[n] == classMarkStamp || f.dist[n] < 0) continue;
+            int c = tileCost(mc, nx, ny);
+            if (c < 0 || f.dist[n] != f.dist[m] + c) continue;
+            classMark[n] = classMarkStamp;
+            classReset.push_back(n);
+        }
+    }
+    for (int i : classReset) f.dist[i] = -1;
+    // seeded from the neighbours that kept their value
+    classHeap.clear();
+    for (int i : classReset) {
+        int d = expected(i);
+        if (d < 0) continue;
+        f.dist[i] = d;
+        classHeap.push_back({d, i});
+        std::push_heap(classHeap.begin(), classHeap.end(), std::greater<>());
+    }
+    runClassSearch(mc);
+}
+
+void Game::invalidateClassFields() {
+    fieldVersion++;
+    for (auto& f : classFields) f.valid = false;
+}
+
+void Game::rebuildPlacementValidity() {
+    const int cols = map.getCols(), rows = map.getRows();
+    const int n = cols * rows;
+    const int root = n; // virtual node linked to every base
+    placementValid.assign(n, 0);
+
+    // tile kinds read once, flat: 0 = wall or tower, else 1 + tile value
+    dfsTile.resize(n);
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < cols; ++x) {
+            int v = map.getTile(x, y);
+            dfsTile[y * cols + x] = v == 2 || tileBlocked[y][x] ? 0 : static_cast<std::uint8_t>(1 + v);
+        }
+    // only the discovery times need clearing, the rest is set on discovery
+    dfsDisc.assign(n + 1, 0);
+    dfsLow.resize(n + 1);
+    dfsParent.resize(n + 1);
+    dfsSpawns.resize(n + 1);
+    dfsNext.resize(n + 1);
+    dfsCut.resize(n); // spawns that lose every base if the tile is blocked
+    dfsStack.clear();
+    const auto& bases = map.getBases();
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    int timer = 1;
+    dfsDisc[root] = dfsLow[root] = timer++;
+    dfsParent[root] = -1;
+    dfsNext[root] = 0;
+    dfsStack.push_back(root);
+    while (!dfsStack.empty()) {
+        int v = dfsStack.back();
+        int w = -1;
+        // next unexplored neighbor of v (the root's neighbors are the bases)
+        if (v == root) {
+            if (dfsNext[v] < static_cast<int>(bases.size())) {
+                const auto& b = bases[dfsNext[v]++];
+                w = b.y * cols + b.x;
+            }
         } else {
-            // fully mixed 50/50 for later waves
-            type = (std::rand() % 2 == 0) ? 2 : 1;
-        }
-        spawnQueue.push_back({type, hp});
-    }
-}
-
-void Game::cleanupDeadStuff() {
-    // remove dead projectiles
-    projectiles.erase(
-        std::remove_if(projectiles.begin(), projectiles.end(),
-            [](auto& p){ return p->dead; }),
-        projectiles.end()
-    );
-
-    // remove dead enemies + track if they reached base or were killed
-    enemies.erase(
-        std::remove_if(enemies.begin(), enemies.end(),
-            [this](auto& e){
-                if (!e->isAlive()) {
-                    // Check if at base tile
-                    const Map& m = this->getMap();
-                    float ts = m.getTileSize();
-                    int tx = static_cast<int>(e->getPosition().x / ts);
-                    int ty = static_cast<int>(e->getPosition().y / ts);
-                    
-                    if (m.getTile(tx, ty) == 3) {
-                        // Reached base: damage player
-                        damagePlayer(1);
-                    } else {
-                        // Killed by tower: reward
-                        money += 10;
-                    }
-                    return true;
+            int x = v % cols, y = v / cols;
+            while (w < 0 && dfsNext[v] < 4) {
+                int k = dfsNext[v]++;
+                int nx = x + dx[k], ny = y + dy[k];
+                if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+                if (dfsTile[ny * cols + nx]) w = ny * cols + nx;
+            }
+        }
+        if (w >= 0) {
+            if (dfsDisc[w] == 0) {
+                dfsParent[w] = v;
+                dfsDisc[w] = dfsLow[w] = timer++;
+                dfsNext[w] = 0;
+                dfsCut[w] = 0;
+                int tv = dfsTile[w] - 1;
+                dfsSpawns[w] = tv == 4 ? 1 : 0;
+                // bases also have an edge back to the root
+                if (tv == 3) dfsLow[w] = dfsDisc[root];
+                dfsStack.push_back(w);
+            } else {
+                dfsLow[v] = std::min(dfsLow[v], dfsDisc[w]);
+            }
+            continue;
+        }
+        // v is finished: hand its low-link and spawn count up to the parent
+        dfsStack.pop_back();
+        int p = dfsParent[v];
+        if (p < 0) continue;
+        dfsLow[p] = std::min(dfsLow[p], dfsLow[v]);
+        dfsSpawns[p] += dfsSpawns[v];
+        // v's subtree only reaches the bases through p
+        if (p != root && dfsLow[v] >= dfsDisc[p]) dfsCut[p] += dfsSpawns[v];
+    }
+
+    // a spawn already cut off leaves no valid placement (same rule as before)
+    for (const auto& sp : map.getSpawns()) {
+        if (dfsDisc[sp.y * cols + sp.x] == 0) return;
+    }
+    for (int i = 0; i < n; ++i) {
+        // not a wall, tower, base or spawn, and not cut (tiles the DFS never reached are not either)
+        int t = dfsTile[i];
+        placementValid[i] = t != 0 && t != 1 + 3 && t != 1 + 4 && (dfsDisc[i] == 0 || dfsCut[i] == 0);
+    }
+    // no towers too close to the spawns and bases
+    auto ban = [&](const sf::Vector2i& c) {
+        int r = placementBanRadiusTiles;
+        for (int y = std::max(0, c.y - r); y <= std::min(rows - 1, c.y + r); ++y)
+            for (int x = std::max(0, c.x - r); x <= std::min(cols - 1, c.x + r); ++x)
+                if ((x - c.x) * (x - c.x) + (y - c.y) * (y - c.y) <= r * r) placementValid[y * cols + x] = 0;
+    };
+    for (const auto& sp : map.getSpawns()) ban(sp);
+    for (const auto& b : bases) ban(b);
+}
+
+void Game::updatePathsAt(int tx, int ty) {
+    rebuildPlacementValidity();
+    // heavies around the tile; flyers ignore towers, their field is left as is
+    sf::Vector2i tile(tx, ty);
+    repairClassFields(&tile, 1);
+    if (!useHierarchy || hierarchy.empty()) {
+        computeDistanceField();
+        return;
+    }
+    hierarchy.setOpen(tx, ty, map.getTile(tx, ty) != 2 && !tileBlocked[ty][tx]);
+}
+
+void Game::computeBFS(){
+    invalidateClassFields();
+    rebuildPlacementValidity();
+    computeDistanceField();
+}
+
+void Game::computeDistanceField() {
+    // one multi-source BFS from every base: distance is to the nearest base
+    const auto& bases = map.getBases();
+    if (bases.empty()) {
+        // no base found (the editor may have painted over the last one):
+        // nothing is reachable, and the next base goes through a full build
+        useHierarchy = false;
+        hierarchy.clear();
+        distance.assign(map.getCols() * map.getRows(), -1);
+        return;
+    }
+    useHierarchy = map.getCols() * map.getRows() >= hierarchicalMinTiles;
+    if (useHierarchy) {
+        std::vector<std::uint8_t> open(map.getCols() * map.getRows());
+        for (int y = 0; y < map.getRows(); ++y)
+            for (int x = 0; x < map.getCols(); ++x)
+                open[y * map.getCols() + x] = map.getTile(x, y) != 2 && !tileBlocked[y][x];
+        hierarchy.build(map.getCols(), map.getRows(), open, bases);
+        distance.clear();
+        return;
+    }
+    hierarchy.clear();
+    // whole BFS layers at a time on packed bitboards
+    bitBfs.run(map.getCols(), map.getRows(), [&](int x, int y) { return map.getTile(x, y) != 2 && !tileBlocked[y][x]; }, bases, distance);
+}
+
+void Game::applyTileEdits(const std::vector<sf::Vector2i>& tiles) {
+    if (tiles.empty()) return;
+    if (!useHierarchy || hierarchy.empty() || map.getBases().empty()) {
+        // small maps: one bitboard BFS for the whole batch is a fraction of a
+        // millisecond. Also when the last base goes or the first one comes
+        // back: computeDistanceField decides again whether to use the hierarchy
+        computeDistanceField();
+    } else {
+        // large maps: only the clusters under the stroke are rebuilt
+        for (const auto& t : tiles) {
+            int v = map.getTile(t.x, t.y);
+            hierarchy.stageOpen(t.x, t.y, v != 2 && !tileBlocked[t.y][t.x]);
+            hierarchy.stageBase(t.x, t.y, v == 3);
+        }
+        hierarchy.commit();
+    }
+    // heavies and flyers: only what the edited tiles changed
+    repairClassFields(tiles.data(), static_cast<int>(tiles.size()));
+    if (!spawnPoints.empty()) spawnPoints = map.getSpawns();
+}
+
+void Game::reserveEntityStorage() {
+    // enemies alive at once are bounded by the wave, shots in flight by the
+    // towers (a few each): everything per-entity grows here, at wave start or
+    // tower placement, so the ticks in between never have to
+    size_t maxEnemies = enemies.size() + static_cast<size_t>(pendingSpawns);
+    size_t maxShots = towers.size() * 4;
+    enemies.reserve(maxEnemies);
+    enemyPool.reserve(maxEnemies);
+    enemyGrid.reserve(maxEnemies);
+    progress.reserve(maxEnemies);
+    crowdPushX.reserve(maxEnemies);
+    crowdPushY.reserve(maxEnemies);
+    projectiles.reserve(maxShots);
+    projectilePool.reserve(maxShots);
+    scheduledHits.reserve(maxShots);
+    freeHitSlots.reserve(maxShots);
+    deathEvents.reserve(maxEnemies + maxShots);
+    // reloads + hits in flight + a few for the wave coroutines
+    timers.reserve(towers.size() + maxShots + 8);
+    // the pools are filled up front too: how many are alive at once depends
+    // on how fast they die, and a new high mid-wave would allocate
+    while (enemies.size() + enemyPool.size() < maxEnemies) {
+        enemyPool.push_back(std::make_shared<Enemy>(sf::Vector2f(), this, 0.f, 1));
+    }
+    while (projectiles.size() + projectilePool.size() < maxShots) {
+        projectilePool.push_back(std::make_unique<Projectile>(sf::Vector2f(), sf::Vector2f(), 0.f, 0.f, this));
+    }
+}
+
+void Game::reportDeath(DeathCause cause, int towerId, int enemyType, const sf::Vector2f& pos) {
+    deathEvents.push_back({cause, towerId, enemyType, pos});
+}
+
+void Game::processDeathEvents() {
+    bool enemyDied = false;
+    for (const DeathEvent& ev : deathEvents) {
+        if (ev.cause != DeathCause::Expired) {
+            // the last enemy of a class invalidates its distance field; the
+            // storage stays for the next wave of that class
+            ClassField& f = classFields[static_cast<int>(Enemy::moveClassOf(ev.enemyType))];
+            if (--f.live <= 0) {
+                f.live = 0;
+                f.valid = false;
+            }
+        }
+        switch (ev.cause) {
+            case DeathCause::KilledByTower: {
+                particles.kill(ev.pos, Enemy::fillColorOf(ev.enemyType));
+                money += killReward;
+                stats.kills++;
+                if (ev.towerId >= 0 && ev.towerId < static_cast<int>(towerById.size()) && towerById[ev.towerId]) {
+                    towerById[ev.towerId]->addKill();
                 }
-                return false;
-            }),
-        enemies.end()
-    );
+                liveEnemies--;
+                enemyDied = true;
+                break;
+            }
+            case DeathCause::Leaked:
+                particles.leak(ev.pos);
+                damagePlayer(1);
+                stats.leaks++;
+                liveEnemies--;
+                enemyDied = true;
+                break;
+            case DeathCause::Expired:
+                stats.expiredShots++;
+                break;
+        }
+    }
+    deathEvents.clear();
+    if (enemyDied) waves.fieldChanged();
 }
 
 void Game::damagePlayer(int dmg) {
@@ -214,44 +649,619 @@ void Game::damagePlayer(int dmg) {
         gameOver = true;
     }
     // Pulse base portal visually when base is hit
-    basePortalPulse = 1.0f;
+    basePortalPulse.set(simTime, 1.f, -1.4f);
+}
+
+void Game::fireProjectile(const Tower& tower, const std::shared_ptr<Enemy>& target, float speed, float damage, int projType) {
+    if (!target) return;
+    sf::Vector2f from = tower.getPosition();
+    sf::Vector2f aim = target->getPosition();
+    float flightTime = std::hypot(aim.x - from.x, aim.y - from.y) / speed;
+
+    if (hitMode == HitMode::Scheduled) {
+        // solve the intercept by fixed-point iteration on the predicted path:
+        // converges quickly because projectiles are much faster than enemies
+        for (int i = 0; i < 4; ++i) {
+            aim = target->predictPosition(flightTime);
+            flightTime = std::hypot(aim.x - from.x, aim.y - from.y) / speed;
+        }
+    }
+
+    sf::Vector2f dir = aim - from;
+    float len = std::hypot(dir.x, dir.y);
+    if (len <= 0.1f) return;
+    dir /= len;
+
+    std::unique_ptr<Projectile> p;
+    if (!projectilePool.empty()) {
+        p = std::move(projectilePool.back());
+        projectilePool.pop_back();
+        *p = Projectile(from, dir, speed, damage, this, projType);
+    } else {
+        p = std::make_unique<Projectile>(from, dir, speed, damage, this, projType);
+    }
+    // a little past the range so shots at the edge still connect
+    p->maxTravel = tower.getRange() + map.getTileSize();
+    p->towerId = tower.getId();
+    if (hitMode == HitMode::Scheduled) {
+        p->visualOnly = true;
+        p->lifeTime = flightTime;
+        int slot;
+        if (!freeHitSlots.empty()) {
+            slot = freeHitSlots.back();
+            freeHitSlots.pop_back();
+            scheduledHits[slot] = {target, target->getSerial(), damage, tower.getId(), projType};
+        } else {
+            slot = static_cast<int>(scheduledHits.size());
+            scheduledHits.push_back({target, target->getSerial(), damage, tower.getId(), projType});
+        }
+        timers.schedule(flightTime, [this, slot]() { resolveScheduledHit(slot); });
+    }
+    projectiles.push_back(std::move(p));
+}
+
+void Game::resolveScheduledHit(int slot) {
+    ScheduledHit& hit = scheduledHits[slot];
+    // the target may have died or leaked (and been recycled) while the shot was in flight
+    auto e = hit.target.lock();
+    if (e && e->getSerial() == hit.serial && e->isAlive()) {
+        applyProjectileHit(*e, hit.damage, hit.towerId, hit.projType);
+    } else {
+        reportDeath(DeathCause::Expired, hit.towerId, 0, e ? e->getPosition() : sf::Vector2f());
+    }
+    hit.target.reset();
+    freeHitSlots.push_back(slot);
+}
+
+void Game::applyProjectileHit(Enemy& e, float damage, int towerId, int projType) {
+    e.takeDamage(damage, towerId);
+    // fire arrows set the target ablaze: 40% of the hit again over 2 seconds
+    if (projType == 1) {
+        particles.fireHit(e.getPosition());
+        if (e.isAlive()) e.applyBurn(damage * 0.2f, 2.f, towerId);
+    }
+}
+
+void Game::rebuildSlowGrid() {
+    int cols = map.getCols(), rows = map.getRows();
+    slowGrid.assign(static_cast<size_t>(cols) * rows, 1.f);
+    float ts = map.getTileSize();
+    for (const auto& t : towers) {
+        auto* ft = dynamic_cast<const FreezingTower*>(t.get());
+        if (!ft) continue;
+        // stamp the aura disc onto the tiles whose centers it covers
+        sf::Vector2f c = ft->getPosition();
+        float r = ft->getSlowRadius();
+        int x0 = std::max(0, static_cast<int>((c.x - r) / ts));
+        int x1 = std::min(cols - 1, static_cast<int>((c.x + r) / ts));
+        int y0 = std::max(0, static_cast<int>((c.y - r) / ts));
+        int y1 = std::min(rows - 1, static_cast<int>((c.y + r) / ts));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                sf::Vector2f d = map.tileCenter(x, y) - c;
+                if (d.x * d.x + d.y * d.y > r * r) continue;
+                float& cell = slowGrid[y * cols + x];
+                cell = std::min(cell, ft->getSlowFactor());
+            }
+        }
+    }
 }
 
-int Game::getWaveEnemyCount(int wave) const {
-    // Progressive waves: more enemies each wave (gentle growth)
-    return 3 + wave;  // Wave 0:3, Wave1:4, Wave2:5, etc.
+void Game::spawnEnemy(const SpawnInfo& info) {
+    if (info.spawn < 0 || info.spawn >= static_cast<int>(spawnPoints.size())) return;
+    const sf::Vector2i& sp = spawnPoints[info.spawn];
+    sf::Vector2f spawnPos = map.tileCenter(sp.x, sp.y);
+    // offset to avoid overlap
+    float offx = (randomInt(3) - 1) * 8.f; // -8, 0, 8
+    float offy = randomInt(3) * 4.f;
+    spawnPos.x += offx;
+    spawnPos.y += offy;
+    std::shared_ptr<Enemy> e;
+    if (!enemyPool.empty()) {
+        e = std::move(enemyPool.back());
+        enemyPool.pop_back();
+        e->reset(spawnPos, info.hp, info.type);
+    } else {
+        e = std::make_shared<Enemy>(spawnPos, this, info.hp, info.type);
+    }
+    enemies.push_back(e);
+    progress.add(e.get());
+    liveEnemies++;
+    classFields[static_cast<int>(e->getMoveClass())].live++;
 }
 
 void Game::run() {
     currentWave = 0;
-    waveTimer = 0.f;
 
+    applyFramePacing();
+    bool redraw = true; // first frame
     while (window.isOpen()) {
+        AllocTracker::beginFrame();
         // process events
-        processEvents();
+        redraw |= processEvents();
+        redraw |= pollAssetChanges();
+        redraw |= pollNet(netClock.getElapsedTime());
+        redraw |= editor.flush();
         float dt = clock.restart().asSeconds();
+        redraw |= updateCamera(dt);
+
+        // menu, pause and game over: nothing animates, so unless the player
+        // did something the last frame is still on screen; nap instead of
+        // redrawing it (input is still polled idlePollMs apart)
+        bool idle = !gameStarted || paused || gameOver;
+        if (idle && !redraw) {
+            if (net) net->send(netClock.getElapsedTime());
+            sf::sleep(sf::milliseconds(idlePollMs));
+            continue;
+        }
+        redraw = false;
 
         if (gameStarted && !gameOver) {
-            update(dt);
+            advanceSimulation(dt);
         }
+        // the governor only sees drawing: cutting detail cannot make the simulation cheaper
+        workClock.restart();
+        if (!paused) particles.update(dt);
+        // right after stepping, so the frame just closed leaves this frame
+        if (net) net->send(netClock.getElapsedTime());
         // if game is over, you can choose to display overlay and wait for start
+        frameTime = dt;
         render();
+        // read before display(): with vsync it blocks until the next vblank
+        float drawSeconds = workClock.getElapsedTime().asSeconds();
+        window.display();
+        // only frames that simulate say something about the load
+        if (gameStarted && !paused && !gameOver && quality.frame(drawSeconds)) {
+            applyQuality();
+        }
+        pacer.wait();
     }
 }
 
-void Game::processEvents() {
+void Game::advanceSimulation(float frameDt) {
+    if (paused) {
+        simAccumulator = 0.f;
+        return;
+    }
+    const int speed = SpeedLevels[speedIndex];
+    // a stall (window drag, breakpoint) must not come back as a burst of ticks
+    frameDt = std::min(frameDt, 0.25f);
+    // counted in ticks: with power-of-two speeds a steady frame adds an exact amount
+    simAccumulator += frameDt * speed / SimStep;
+    sf::Clock budget;
+    int steps = 0;
+    while (simAccumulator >= 1.f && !gameOver) {
+        if (steps == maxStepsPerFrame || budget.getElapsedTime().asSeconds() > stepBudget) break;
+        if (!stepSimulation()) {
+            // waiting on the peer is not the sim being slow: keep a few ticks
+            // to catch up with once its inputs arrive, forget the rest
+            simAccumulator = std::min(simAccumulator, 8.f);
+            if (steps == 0) ++netStallFrames;
+            return;
+        }
+        netStallFrames = 0;
+        simAccumulator -= 1.f;
+        ++steps;
+    }
+    // Falling behind: drop the backlog rather than carry it into the next
+    // frame, where it would only make that frame slower (the spiral). The sim
+    // then simply runs slower than asked; the UI shows the achieved speed.
+    bool behind = simAccumulator >= 1.f;
+    if (behind) simAccumulator -= std::floor(simAccumulator);
+    float achieved = frameDt > 0.f ? steps * SimStep / frameDt : static_cast<float>(speed);
+    effectiveSpeed += (achieved - effectiveSpeed) * 0.1f;
+    behindFrames = behind ? behindFrames + 1 : 0;
+    if (behindFrames == 30) {
+        std::cout << "Simulation can't keep up with x" << speed << ": running at about x"
+                  << effectiveSpeed << " (" << steps << " ticks/frame)" << std::endl;
+    }
+}
+
+bool Game::stepSimulation() {
+    if (!net) {
+        update(SimStep);
+        return true;
+    }
+    std::uint32_t tick = static_cast<std::uint32_t>(simTicks);
+    if (!net->isReady(tick)) return false;
+    Lockstep::Command cmds[2 * Lockstep::MaxCommandsPerFrame];
+    int n = net->beginTick(tick, cmds, 2 * Lockstep::MaxCommandsPerFrame);
+    for (int i = 0; i < n; ++i) applyCommand(cmds[i]);
+    update(SimStep);
+    net->endTick(tick, stateHash());
+    return true;
+}
+
+void Game::issueCommand(const Lockstep::Command& c) {
+    // alone, an input is just applied; in co-op it waits for its tick
+    if (!net) {
+        applyCommand(c);
+        return;
+    }
+    if (!net->submit(c)) std::cout << "Too many commands this tick, dropped one" << std::endl;
+}
+
+void Game::applyCommand(const Lockstep::Command& c) {
+    switch (c.kind) {
+        case Lockstep::CommandKind::PlaceTower:
+            tryPlaceTower(c.a, c.b, c.c);
+            break;
+        case Lockstep::CommandKind::UpgradeTower:
+            tryUpgradeTower(c.a);
+            break;
+        case Lockstep::CommandKind::SellTower:
+            trySellTower(c.a);
+            break;
+        case Lockstep::CommandKind::SetPolicy:
+            if (c.a >= 0 && c.a < static_cast<int>(towerById.size()) && towerById[c.a] &&
+                c.b >= 0 && c.b < TargetPolicyCount)
+                towerById[c.a]->setPolicy(static_cast<TargetPolicy>(c.b));
+            break;
+        default:
+            break;
+    }
+}
+
+bool Game::pollNet(sf::Time now) {
+    if (!net) return false;
+    net->receive(now);
+    if (net->isConnected() && !gameStarted && !gameOver) {
+        std::cout << "Co-op: connected as player " << net->getPlayer() + 1 << ", seed " << net->getSeed() << std::endl;
+        seedFixed = true;
+        matchSeed = net->getSeed();
+        startNewGame();
+        gameStarted = true;
+        return true;
+    }
+    if (!netReported && (net->isDesynced() || net->isPeerLost())) {
+        netReported = true;
+        if (net->isDesynced()) std::cout << "Co-op: DESYNC at tick " << net->getDesyncTick() << std::endl;
+        else std::cout << "Co-op: peer lost" << std::endl;
+        return true;
+    }
+    return false;
+}
+
+void Game::cycleSimSpeed() {
+    speedIndex = (speedIndex + 1) % SpeedLevelCount;
+    effectiveSpeed = static_cast<float>(SpeedLevels[speedIndex]);
+    behindFrames = 0;
+}
+
+std::uint64_t Game::stateHash() const {
+    // FNV-1a over everything the simulation decides; two runs fed the same
+    // seed and inputs must agree on it after the same tick
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void* data, size_t n) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    };
+    auto mixInt = [&](std::int64_t v) { mix(&v, sizeof(v)); };
+    auto mixFloat = [&](float v) { mix(&v, sizeof(v)); };
+    mixInt(static_cast<std::int64_t>(simTicks));
+    mixInt(money);
+    mixInt(playerHealth);
+    mixInt(currentWave);
+    mixInt(liveEnemies);
+    mixInt(stats.kills);
+    mixInt(stats.leaks);
+    mixInt(static_cast<std::int64_t>(towers.size()));
+    mixInt(static_cast<std::int64_t>(projectiles.size()));
+    for (const auto& e : enemies) {
+        if (!e->isAlive()) continue;
+        sf::Vector2f p = e->getPosition();
+        mixFloat(p.x);
+        mixFloat(p.y);
+        mixFloat(e->getHP());
+        mixInt(e->getType());
+    }
+    return h;
+}
+
+void Game::applyFramePacing() {
+    // vsync paces the loop by itself; the software cap would only fight it
+    window.setVerticalSyncEnabled(vsync);
+    pacer.setTargetFps(vsync ? 0 : frameCap);
+    // a frame has to be built within its slot (vsync: assume 60 Hz)
+    quality.setBudget(1.f / (vsync || frameCap <= 0 ? 60 : frameCap));
+    quality.reset();
+}
+
+void Game::applyQuality() {
+    particles.setBudget(static_cast<int>(particles.getCapacity() * quality.particleShare()));
+    std::cout << "Quality level " << quality.getLevel() << " (frames averaged "
+              << quality.getAverage() * 1000.f << " ms, budget " << quality.getBudget() * 1000.f << " ms)" << std::endl;
+}
+
+int Game::runHeadless(int ticks, bool allocTest, int speed) {
+    const float dt = SimStep;
+    // warm-up: pools, queues and timer nodes reach the size of a full wave
+    const int warmupTicks = 90 * 60;
+    if (allocTest && !AllocTracker::enabled) {
+        std::cerr << "--alloc-test needs a build with -DTD_TRACK_ALLOCS=ON" << std::endl;
+        return 2;
+    }
+    startNewGame();
+    gameStarted = true;
+    // enough towers to hold every wave: the run measures a steady state, not a match
+    money = 1000000;
+    playerHealth = 1000000;
+    if (allocTest) pinnedWave = 8;
+    int placed = 0;
+    const int cols = map.getCols(), rows = map.getRows();
+    for (int y = 0; y < rows && placed < 24; ++y) {
+        for (int x = 0; x < cols && placed < 24; ++x) {
+            // next to the ground route only, so every tower gets to shoot
+            bool nearPath = false;
+            for (int k = 0; k < 4 && !nearPath; ++k) {
+                int nx = x + (k == 0) - (k == 1), ny = y + (k == 2) - (k == 3);
+                nearPath = getDistanceAt(nx, ny) > 0;
+            }
+            if (nearPath && tryPlaceTower(placed % 3, x, y)) ++placed;
+        }
+    }
+    if (allocTest) ticks += warmupTicks;
+
+    AllocTracker::Counts measured;
+    int allocatingTicks = 0, firstBad = -1;
+    sf::Clock wall;
+    if (speed > 1 && !allocTest) {
+        // 60 FPS frames at a fast-forward speed: must end on the same state as x1
+        while (speedIndex + 1 < SpeedLevelCount && SpeedLevels[speedIndex] < speed) ++speedIndex;
+        stepBudget = 1e9f; // measuring determinism, not keeping up
+        while (simTicks + getSimSpeed() <= static_cast<std::uint64_t>(ticks) && !gameOver) advanceSimulation(dt);
+        ticks -= static_cast<int>(simTicks); // the last partial frame runs below
+    }
+    for (int t = 0; t < ticks && !gameOver; ++t) {
+        AllocTracker::beginFrame();
+        update(dt);
+        AllocTracker::Counts c = AllocTracker::frame();
+        if (allocTest && t < warmupTicks) continue;
+        measured.allocs += c.allocs;
+        measured.bytes += c.bytes;
+        measured.frees += c.frees;
+        if (c.allocs == 0) continue;
+        if (allocatingTicks++ == 0) firstBad = t;
+        if (allocTest && allocatingTicks <= 5) {
+            // the zones of that tick tell where to look
+            AllocTracker::beginFrame();
+            std::cerr << "tick " << t << ": " << c.allocs << " allocs, " << c.bytes << " bytes";
+            for (int z = 0; z < AllocTracker::zoneCount(); ++z) {
+                const AllocTracker::Counts& zc = AllocTracker::zoneLastFrame(z);
+                if (zc.allocs) std::cerr << " [" << AllocTracker::zoneName(z) << ": " << zc.allocs << "]";
+            }
+            std::cerr << std::endl;
+        }
+    }
+    int measuredTicks = allocTest ? ticks - warmupTicks : static_cast<int>(simTicks);
+    std::cout << "headless: " << measuredTicks << " ticks (x" << SpeedLevels[speedIndex] << ", seed " << matchSeed
+              << ", state " << std::hex << stateHash() << std::dec << ") in " << wall.getElapsedTime().asMilliseconds() << " ms"
+              << ", wave " << currentWave << ", " << towers.size() << " towers, " << stats.kills << " kills, " << stats.leaks << " leaks" << std::endl;
+    // what the towers cover of the tiles enemies can walk
+    int reachable = 0, covered = 0;
+    float reachableDps = 0.f;
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            if (getDistanceAt(x, y) < 0) continue;
+            ++reachable;
+            if (coverage.coverageAt(x, y) > 0) ++covered;
+            reachableDps += coverage.dpsAt(x, y);
+        }
+    }
+    std::cout << "coverage: " << covered << "/" << reachable << " reachable tiles under fire, "
+              << reachableDps / std::max(1, reachable) << " dps on average" << std::endl;
+    if (!coverageOut.empty()) {
+        std::ofstream out(coverageOut);
+        coverage.write(out);
+        if (!out) std::cerr << "Cannot write " << coverageOut << std::endl;
+    }
+    if (AllocTracker::enabled) {
+        std::cout << "allocations: " << measured.allocs << " (" << measured.bytes << " bytes, "
+                  << measured.frees << " frees) in " << allocatingTicks << " ticks" << std::endl;
+    }
+    if (allocTest && allocatingTicks > 0) {
+        std::cerr << "alloc test FAILED: " << allocatingTicks << " steady-state ticks allocated (first at tick "
+                  << firstBad << ")" << std::endl;
+        return 1;
+    }
+    if (allocTest) std::cout << "alloc test passed" << std::endl;
+    return 0;
+}
+
+int Game::runNetTest(int ticks, sf::Time latency, sf::Time jitter, float loss, int desyncAt) {
+    Game a(true), b(true);
+    Game* games[2] = {&a, &b};
+    a.net = std::make_unique<Lockstep>();
+    b.net = std::make_unique<Lockstep>();
+    if (!a.net->host(sf::Socket::AnyPort, 1234) || !b.net->join(sf::IpAddress::LocalHost, a.net->getLocalPort())) {
+        std::cerr << "net test: could not bind a UDP socket" << std::endl;
+        return 2;
+    }
+    for (Game* g : games) g->net->simulateLink(latency, jitter, loss);
+
+    // scripted players: each tries a tile next to the ground route every two
+    // seconds (they alternate through the same list, so they also collide)
+    std::vector<sf::Vector2i> spots;
+    for (int y = 0; y < a.map.getRows(); ++y) {
+        for (int x = 0; x < a.map.getCols(); ++x) {
+            bool nearPath = false;
+            for (int k = 0; k < 4 && !nearPath; ++k) {
+                nearPath = a.getDistanceAt(x + (k == 0) - (k == 1), y + (k == 2) - (k == 3)) > 0;
+            }
+            if (nearPath && a.canPlaceAt(x, y)) spots.push_back({x, y});
+        }
+    }
+    int nextSpot[2] = {0, 1};
+    std::uint64_t lastOrder[2] = {0, 0}; // 2 s periods already served
+    int stalledFrames[2] = {0, 0};
+    float owed[2] = {0.f, 0.f};
+    int maxEnemies = 0;
+
+    // simulated time: the latency is the link's, not this machine's
+    const sf::Time frame = sf::microseconds(16667);
+    sf::Time now;
+    const int maxFrames = ticks * 4 + 600;
+    int frames = 0;
+    bool done = false;
+    while (!done && frames++ < maxFrames) {
+        now += frame;
+        done = true;
+        for (int i = 0; i < 2; ++i) {
+            Game& g = *games[i];
+            g.pollNet(now);
+            std::uint64_t target = g.gameOver ? g.simTicks : static_cast<std::uint64_t>(ticks);
+            if (g.gameStarted && g.simTicks < target) {
+                // frames step several ticks after a stall: go by period, not by exact tick
+                std::uint64_t period = (g.simTicks + 120 - 60 * i) / 120;
+                if (period != lastOrder[i] && !spots.empty()) {
+                    lastOrder[i] = period;
+                    const sf::Vector2i& s = spots[nextSpot[i] % spots.size()];
+                    Lockstep::Command c;
+                    c.kind = Lockstep::CommandKind::PlaceTower;
+                    c.a = static_cast<std::int16_t>(nextSpot[i] % 3);
+                    c.b = static_cast<std::int16_t>(s.x);
+                    c.c = static_cast<std::int16_t>(s.y);
+                    g.issueCommand(c);
+                    // and retarget the newest tower this side knows of
+                    if (!g.towers.empty()) {
+                        Lockstep::Command p;
+                        p.kind = Lockstep::CommandKind::SetPolicy;
+                        p.a = static_cast<std::int16_t>(g.towers.back()->getId());
+                        p.b = static_cast<std::int16_t>(period % TargetPolicyCount);
+                        g.issueCommand(p);
+                        // now and then upgrade the oldest one, or sell it
+                        if (period % 3 == 0 || period % 7 == 0) {
+                            p.kind = period % 7 == 0 ? Lockstep::CommandKind::SellTower : Lockstep::CommandKind::UpgradeTower;
+                            p.a = static_cast<std::int16_t>(g.towers.front()->getId());
+                            g.issueCommand(p);
+                        }
+                    }
+                    nextSpot[i] += 2;
+                }
+                // one tick per frame, plus catching up after a stall
+                owed[i] = std::min(owed[i] + 1.f, 8.f);
+                int steps = 0;
+                while (owed[i] >= 1.f && !g.gameOver && g.simTicks < target && g.stepSimulation()) {
+                    owed[i] -= 1.f;
+                    ++steps;
+                    // a corrupted client: the hashes must catch it
+                    if (i == 1 && g.simTicks == static_cast<std::uint64_t>(desyncAt)) g.money += 1;
+                }
+                if (steps == 0) ++stalledFrames[i];
+                maxEnemies = std::max(maxEnemies, g.liveEnemies);
+            }
+            g.net->send(now);
+            target = g.gameOver ? g.simTicks : static_cast<std::uint64_t>(ticks);
+            done = done && g.gameStarted && g.simTicks >= target && g.net->getVerifiedTicks() >= g.simTicks;
+        }
+        if (a.net->isDesynced() || b.net->isDesynced()) break;
+    }
+
+    const Lockstep::Stats& sa = a.net->getStats();
+    const Lockstep::Stats& sb = b.net->getStats();
+    double perTick = a.simTicks ? static_cast<double>(sa.bytesSent) / a.simTicks : 0.0;
+    std::cout << "net test: " << a.simTicks << "/" << b.simTicks << " ticks in " << frames << " frames, latency "
+              << latency.asMilliseconds() << " ms (+" << jitter.asMilliseconds() << "), loss " << loss * 100.f << "%" << std::endl;
+    std::cout << "  verified through tick " << std::min(a.net->getVerifiedTicks(), b.net->getVerifiedTicks())
+              << ", state " << std::hex << a.stateHash() << " / " << b.stateHash() << std::dec
+              << ", " << a.towers.size() << " towers, wave " << a.currentWave << ", up to " << maxEnemies << " enemies" << std::endl;
+    std::cout << "  host sent " << sa.packetsSent << " packets (" << perTick << " B/tick), dropped " << sa.packetsDropped
+              << "; client sent " << sb.packetsSent << ", dropped " << sb.packetsDropped
+              << "; stalled frames " << stalledFrames[0] << "/" << stalledFrames[1] << std::endl;
+
+    long long desync = a.net->isDesynced() ? a.net->getDesyncTick() : b.net->isDesynced() ? b.net->getDesyncTick() : -1;
+    if (desyncAt >= 0) {
+        // tampered between ticks: the first hash to differ is tick desyncAt's
+        bool caught = desync == desyncAt;
+        std::cout << (caught ? "net test passed: desync caught at tick " : "net test FAILED: desync reported at tick ")
+                  << desync << " (injected before tick " << desyncAt << ")" << std::endl;
+        return caught ? 0 : 1;
+    }
+    if (desync >= 0) {
+        std::cerr << "net test FAILED: desync at tick " << desync << std::endl;
+        return 1;
+    }
+    if (!done || a.simTicks != b.simTicks || a.stateHash() != b.stateHash()) {
+        std::cerr << "net test FAILED: " << (done ? "final states differ" : "stalled") << std::endl;
+        return 1;
+    }
+    std::cout << "net test passed" << std::endl;
+    return 0;
+}
+
+int Game::runHitTest() {
+    // collision hits: two shots reach a weak enemy in the same tick, with a
+    // strong one right behind it. The first shot kills the weak one, so the
+    // second must fly through the corpse and hit the strong one.
+    Game g(true);
+    g.hitMode = HitMode::Collision;
+    g.startNewGame();
+    const float ts = g.map.getTileSize();
+    g.enemies.clear();
+    g.enemies.push_back(std::make_shared<Enemy>(g.map.tileCenter(3, 2), &g, 10.f, 1));
+    g.enemies.push_back(std::make_shared<Enemy>(g.map.tileCenter(4, 2), &g, 100.f, 1));
+    const Enemy& weak = *g.enemies[0];
+    const Enemy& strong = *g.enemies[1];
+    g.enemyGrid.rebuild(g.enemies);
+
+    sf::Vector2f from = g.map.tileCenter(1, 2);
+    // both cross the two enemies within one step
+    Projectile shots[2] = {Projectile(from, {1.f, 0.f}, ts * 4.f / SimStep, 20.f, &g),
+                           Projectile(from, {1.f, 0.f}, ts * 4.f / SimStep, 20.f, &g)};
+    for (Projectile& p : shots) p.update(SimStep);
+
+    bool ok = !weak.isAlive() && strong.isAlive() && strong.getHP() == 80.f && shots[1].dead;
+    if (!ok) {
+        std::cerr << "hit test FAILED: weak " << (weak.isAlive() ? "alive" : "dead") << ", strong at "
+                  << strong.getHP() << " hp (expected 80)" << std::endl;
+        return 1;
+    }
+    std::cout << "hit test passed" << std::endl;
+    return 0;
+}
+
+bool Game::processEvents() {
     sf::Event ev;
+    bool any = false;
     while (window.pollEvent(ev)) {
+        any = true;
+        if (editor.isActive() && editor.handleEvent(ev)) continue;
         if (ev.type == sf::Event::Closed) window.close();
+        else if (ev.type == sf::Event::Resized) {
+            uiView.reset(sf::FloatRect(0.f, 0.f, static_cast<float>(ev.size.width), static_cast<float>(ev.size.height)));
+            camera.setSize(ev.size.width * cameraZoom, ev.size.height * cameraZoom);
+            clampCamera();
+        }
+        else if (ev.type == sf::Event::MouseWheelScrolled) {
+            // zoom around the cursor
+            if (ev.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel) {
+                zoomCamera(ev.mouseWheelScroll.delta > 0 ? 1.f / 1.15f : 1.15f, {ev.mouseWheelScroll.x, ev.mouseWheelScroll.y});
+            }
+        }
         else if (ev.type == sf::Event::MouseMoved) {
-            sf::Vector2f mousePos(ev.mouseMove.x, ev.mouseMove.y);
+            if (draggingCamera) {
+                sf::Vector2f delta = pixelToWorld(dragLastPixel.x, dragLastPixel.y) - pixelToWorld(ev.mouseMove.x, ev.mouseMove.y);
+                camera.move(delta);
+                clampCamera();
+                dragLastPixel = {ev.mouseMove.x, ev.mouseMove.y};
+            }
+            sf::Vector2f mousePos = pixelToWorld(ev.mouseMove.x, ev.mouseMove.y);
             handleMouseMove(mousePos);
         }
+        else if (ev.type == sf::Event::MouseButtonReleased) {
+            if (ev.mouseButton.button == sf::Mouse::Middle) draggingCamera = false;
+        }
         else if (ev.type == sf::Event::MouseButtonPressed) {
-            sf::Vector2f mousePos(ev.mouseButton.x, ev.mouseButton.y);
+            sf::Vector2f mousePos = pixelToWorld(ev.mouseButton.x, ev.mouseButton.y);
+            if (ev.mouseButton.button == sf::Mouse::Middle) {
+                // middle-drag pans the camera
+                draggingCamera = true;
+                dragLastPixel = {ev.mouseButton.x, ev.mouseButton.y};
+            }
             if (ev.mouseButton.button == sf::Mouse::Left) {
                 if (!gameStarted) {
-                    // start game on any left click when on menu
+                    // start game on any left click when on menu (co-op starts on connect)
+                    if (net) continue;
                     gameStarted = true;
                     startNewGame();
                 } else {
@@ -269,7 +1279,36 @@ void Game::processEvents() {
                 placeTower(2);  // Cannon
             } else if (ev.key.code == sf::Keyboard::Escape) {
                 placingTower = false;
+            } else if (ev.key.code == sf::Keyboard::Home) {
+                resetCamera();
+            } else if (ev.key.code == sf::Keyboard::F3) {
+                showDebug = !showDebug;
+            } else if (ev.key.code == sf::Keyboard::F4) {
+                quality.setEnabled(!quality.isEnabled());
+                applyQuality();
+            } else if (ev.key.code == sf::Keyboard::V) {
+                vsync = !vsync;
+                applyFramePacing();
+            } else if (ev.key.code == sf::Keyboard::Tab && !net) {
+                cycleSimSpeed();
+            } else if (ev.key.code == sf::Keyboard::H) {
+                showCoverage = !showCoverage;
+            } else if (Tower* t = getSelectedTower()) {
+                Lockstep::Command c;
+                c.a = static_cast<std::int16_t>(t->getId());
+                if (ev.key.code == sf::Keyboard::T) {
+                    c.kind = Lockstep::CommandKind::SetPolicy;
+                    c.b = static_cast<std::int16_t>((static_cast<int>(t->getPolicy()) + 1) % TargetPolicyCount);
+                } else if (ev.key.code == sf::Keyboard::U) {
+                    c.kind = Lockstep::CommandKind::UpgradeTower;
+                } else if (ev.key.code == sf::Keyboard::Delete) {
+                    c.kind = Lockstep::CommandKind::SellTower;
+                }
+                if (c.kind != Lockstep::CommandKind::None) issueCommand(c);
             }
+            // the rest would need the co-op peer to agree
+            if (net) continue;
+            if (ev.key.code == sf::Keyboard::E && gameStarted) editor.open();
             // Pause/resume
             if (ev.key.code == sf::Keyboard::P) {
                 paused = !paused;
@@ -287,6 +1326,65 @@ void Game::processEvents() {
             }
         }
     }
+    return any;
+}
+
+void Game::resetCamera() {
+    sf::Vector2u ws = window.getSize();
+    uiView.reset(sf::FloatRect(0.f, 0.f, static_cast<float>(ws.x), static_cast<float>(ws.y)));
+    cameraZoom = 1.f;
+    camera.setSize(static_cast<float>(ws.x), static_cast<float>(ws.y));
+    // start on the first spawn so large maps open where the action is
+    auto sp = map.findSpawn();
+    camera.setCenter(sp.first >= 0 ? map.tileCenter(sp.first, sp.second) : sf::Vector2f(ws.x / 2.f, ws.y / 2.f));
+    clampCamera();
+}
+
+void Game::clampCamera() {
+    // keep the view over the map; a view larger than the map is centered on it
+    float mapW = map.getCols() * map.getTileSize();
+    float mapH = map.getRows() * map.getTileSize();
+    sf::Vector2f size = camera.getSize();
+    sf::Vector2f c = camera.getCenter();
+    c.x = size.x >= mapW ? mapW / 2.f : std::clamp(c.x, size.x / 2.f, mapW - size.x / 2.f);
+    c.y = size.y >= mapH ? mapH / 2.f : std::clamp(c.y, size.y / 2.f, mapH - size.y / 2.f);
+    camera.setCenter(c);
+}
+
+bool Game::updateCamera(float dt) {
+    if (!window.hasFocus()) return false;
+    sf::Vector2f pan(0.f, 0.f);
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) pan.x -= 1.f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) pan.x += 1.f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) pan.y -= 1.f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) pan.y += 1.f;
+    if (pan.x == 0.f && pan.y == 0.f) return false;
+    camera.move(pan * (cameraPanSpeed * cameraZoom * dt));
+    clampCamera();
+    return true;
+}
+
+void Game::zoomCamera(float factor, const sf::Vector2i& pixel) {
+    // zoom out at most until the whole map fits, in at most 4x
+    sf::Vector2u ws = window.getSize();
+    float mapW = map.getCols() * map.getTileSize();
+    float mapH = map.getRows() * map.getTileSize();
+    float maxZoom = std::max(1.f, std::max(mapW / ws.x, mapH / ws.y));
+    float newZoom = std::clamp(cameraZoom * factor, 0.25f, maxZoom);
+    if (newZoom == cameraZoom) return;
+    // keep the world point under the cursor fixed
+    sf::Vector2f before = pixelToWorld(pixel.x, pixel.y);
+    camera.setSize(ws.x * newZoom, ws.y * newZoom);
+    cameraZoom = newZoom;
+    sf::Vector2f after = pixelToWorld(pixel.x, pixel.y);
+    camera.move(before - after);
+    clampCamera();
+}
+
+sf::FloatRect Game::getVisibleWorldRect() const {
+    sf::Vector2f c = camera.getCenter();
+    sf::Vector2f size = camera.getSize();
+    return sf::FloatRect(c.x - size.x / 2.f, c.y - size.y / 2.f, size.x, size.y);
 }
 
 void Game::placeTower(int towerType) {
@@ -299,53 +1397,53 @@ void Game::placeTower(int towerType) {
 }
 
 void Game::handleMouseMove(const sf::Vector2f& mousePos) {
+    mouseWorld = mousePos;
     if (placingTower) {
         previewPos = mousePos;
     }
 }
 
+Tower* Game::towerAtTile(int tx, int ty) const {
+    for (auto& t : towers) {
+        sf::Vector2f p = t->getPosition();
+        if (static_cast<int>(p.x / map.getTileSize()) == tx && static_cast<int>(p.y / map.getTileSize()) == ty)
+            return t.get();
+    }
+    return nullptr;
+}
+
 void Game::handleMouseClick(const sf::Vector2f& mousePos) {
-    if (!placingTower) return;
-    
-    // Get tower cost based on type
-    int cost = 0;
-    std::unique_ptr<Tower> newTower = nullptr;
-    
     // compute tile coords under mouse
     int tx = static_cast<int>(mousePos.x / map.getTileSize());
     int ty = static_cast<int>(mousePos.y / map.getTileSize());
-
-    // basic tile validity
-    if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows()) return;
-    int tileVal = map.getTile(tx, ty);
-    if (tileVal == 2) return; // can't place on obstacle
-    if (tileBlocked[ty][tx]) return; // can't place on existing tower
+    if (!placingTower) {
+        // selection is local: only the policy change goes to the peer
+        Tower* t = towerAtTile(tx, ty);
+        selectedTowerId = t ? t->getId() : -1;
+        return;
+    }
+    Lockstep::Command c;
+    c.kind = Lockstep::CommandKind::PlaceTower;
+    c.a = static_cast<std::int16_t>(selectedTowerType);
+    c.b = static_cast<std::int16_t>(tx);
+    c.c = static_cast<std::int16_t>(ty);
+    issueCommand(c);
     
-    // don't allow placing on the spawn or base tiles
-    if (tileVal == 3 || tileVal == 4) return;
+    // Continue placing towers of same type
+}
 
-    // don't allow placement too close to spawn/base
-    auto base = map.findBase();
-    std::pair<int,int> spawnTile = {-1,-1};
-    // find spawn
-    for (int sy = 0; sy < map.getRows(); ++sy) {
-        for (int sx = 0; sx < map.getCols(); ++sx) {
-            if (map.getTile(sx, sy) == 4) { spawnTile = {sx, sy}; goto spawn_found; }
-        }
-    }
-spawn_found:;
-    auto distTiles = [](int ax, int ay, int bx, int by){ int dx = ax - bx; int dy = ay - by; return std::sqrt(dx*dx + dy*dy); };
-    if (spawnTile.first != -1) {
-        if (distTiles(tx, ty, spawnTile.first, spawnTile.second) <= placementBanRadiusTiles) return;
-    }
-    if (base.first != -1) {
-        if (distTiles(tx, ty, base.first, base.second) <= placementBanRadiusTiles) return;
-    }
+bool Game::tryPlaceTower(int towerType, int tx, int ty) {
+    // tile rules, ban radius and path cuts are all precomputed
+    if (!canPlaceAt(tx, ty)) return false;
+
+    // Get tower cost based on type
+    int cost = 0;
+    std::unique_ptr<Tower> newTower = nullptr;
 
     // create tower at tile center
     sf::Vector2f placementPos = map.tileCenter(tx, ty);
     
-    switch (selectedTowerType) {
+    switch (towerType) {
         case 0:  // Sniper
             cost = 75;
             newTower = std::make_unique<SniperTower>(placementPos, this);
@@ -362,121 +1460,245 @@ spawn_found:;
     
     // Check if player has enough money
     if (newTower && money >= cost) {
-        // reserve the funds first
         money -= cost;
-        // mark tile blocked tentatively
+        // canPlaceAt guarantees every spawn still reaches a base
         tileBlocked[ty][tx] = true;
-        // recompute BFS to account for new obstacle and verify spawn has valid path
-        computeBFS();
-        // find spawn tile
-        int sX=-1, sY=-1;
-        for (int sy = 0; sy < map.getRows(); ++sy) {
-            for (int sx = 0; sx < map.getCols(); ++sx) {
-                if (map.getTile(sx, sy) == 4) { sX=sx; sY=sy; goto spawn_found2; }
-            }
-        }
-spawn_found2:;
-        bool spawnReachable = true;
-        if (sX >=0 && sY >=0) {
-            if (distance[sY][sX] == -1) spawnReachable = false;
-        }
-        if (!spawnReachable) {
-            // revert block and refund
-            tileBlocked[ty][tx] = false;
-            money += cost; // refund
-            // do not place the tower
-        } else {
-            // commit the tower
-            towers.push_back(std::move(newTower));
-        }
+        updatePathsAt(tx, ty);
+        newTower->setId(nextTowerId++);
+        towerById.push_back(newTower.get());
+        coverage.stamp(newTower->getPosition(), newTower->getRange(), newTower->getDps(), +1);
+        towers.push_back(std::move(newTower));
+        rebuildSlowGrid();
+        reserveEntityStorage();
+        return true;
+    }
+    return false;
+}
+
+bool Game::tryUpgradeTower(int id) {
+    if (id < 0 || id >= static_cast<int>(towerById.size()) || !towerById[id]) return false;
+    Tower& t = *towerById[id];
+    if (money < t.getUpgradeCost()) return false;
+    money -= t.getUpgradeCost();
+    // range and dps both grow: swap the old disc for the new one
+    coverage.stamp(t.getPosition(), t.getRange(), t.getDps(), -1);
+    t.upgrade();
+    coverage.stamp(t.getPosition(), t.getRange(), t.getDps(), +1);
+    return true;
+}
+
+bool Game::trySellTower(int id) {
+    if (id < 0 || id >= static_cast<int>(towerById.size()) || !towerById[id]) return false;
+    Tower* t = towerById[id];
+    sf::Vector2f p = t->getPosition();
+    coverage.stamp(p, t->getRange(), t->getDps(), -1);
+    int tx = static_cast<int>(p.x / map.getTileSize());
+    int ty = static_cast<int>(p.y / map.getTileSize());
+    removeTower(t);
+    updatePathsAt(tx, ty);
+    rebuildSlowGrid();
+    return true;
+}
+
+void Game::removeTower(Tower* t) {
+    money += t->getSellValue();
+    sf::Vector2f p = t->getPosition();
+    int tx = static_cast<int>(p.x / map.getTileSize());
+    int ty = static_cast<int>(p.y / map.getTileSize());
+    if (tx >= 0 && ty >= 0 && tx < map.getCols() && ty < map.getRows()) tileBlocked[ty][tx] = false;
+    int id = t->getId();
+    if (id >= 0 && id < static_cast<int>(towerById.size())) towerById[id] = nullptr;
+    if (selectedTowerId == id) selectedTowerId = -1;
+    // keep the order: towers update in placement order on both co-op peers
+    towers.erase(std::find_if(towers.begin(), towers.end(), [t](const auto& u) { return u.get() == t; }));
+}
+
+void Game::rebuildCoverage() {
+    if (coverage.getCols() != map.getCols() || coverage.getRows() != map.getRows())
+        coverage.init(map.getCols(), map.getRows(), map.getTileSize());
+    else
+        coverage.clear();
+    for (const auto& t : towers) coverage.stamp(t->getPosition(), t->getRange(), t->getDps(), +1);
+}
+
+void Game::separateCrowd(float dt) {
+    if (enemies.size() < 2) return;
+    enemyGrid.separation(crowdSpacing, crowdPushX, crowdPushY);
+    float k = std::min(1.f, crowdStiffness * dt);
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        if (crowdPushX[i] == 0.f && crowdPushY[i] == 0.f) continue;
+        sf::Vector2f p = enemies[i]->nudge({crowdPushX[i] * k, crowdPushY[i] * k});
+        // keep the grid in sync for this tick's projectile sweeps
+        enemyGrid.setPosition(static_cast<int>(i), p.x, p.y);
     }
-    
-    // Continue placing towers of same type
 }
 
 void Game::update(float dt) {
     if (paused) return;
+    simTime += dt;
+    ++simTicks;
     // Update portal animation global timer
     portalAnimTime += dt;
-    // Update portal pulse states
-    if (!spawnQueue.empty()) spawnPortalPulse = std::min(spawnPortalPulse + dt * 2.5f, 1.f);
-    else spawnPortalPulse = std::max(spawnPortalPulse - dt * 1.2f, 0.f);
-    basePortalPulse = std::max(basePortalPulse - dt * 1.4f, 0.f);
-
-    // spawn queue handling: spawn enemies sequentially in the spawn queue
-    if (!spawnQueue.empty()) {
-        spawnTimer -= dt;
-        if (spawnTimer <= 0.f) {
-            // spawn one enemy at spawnTileX/Y
-            if (spawnTileX >= 0 && spawnTileY >= 0) {
-                sf::Vector2f spawnPos = map.tileCenter(spawnTileX, spawnTileY);
-                // offset to avoid overlap
-                float offx = (std::rand() % 3 - 1) * 8.f; // -8, 0, 8
-                float offy = (std::rand() % 3) * 4.f;
-                spawnPos.x += offx;
-                spawnPos.y += offy;
-                auto info = spawnQueue.front();
-                float hp = info.hp; // hp set during spawnEnemyWave
-                int type = info.type;
-                auto e = std::make_shared<Enemy>(spawnPos, this, hp, type);
-                enemies.push_back(e);
+    // fire due timers: tower reloads, queued spawns, next wave, scheduled hits
+    {
+        TD_PROFILE_ZONE("timers");
+        timers.advance(dt);
+    }
+
+    // Update enemies (BFS-guided); enemies that died since the last update are
+    // compacted in the same pass with swap-and-pop, into the pool
+    {
+        TD_PROFILE_ZONE("enemies");
+        for (size_t i = 0; i < enemies.size();) {
+            if (enemies[i]->isAlive()) enemies[i]->update(dt);
+            if (!enemies[i]->isAlive()) {
+                enemyPool.push_back(std::move(enemies[i]));
+                enemies[i] = std::move(enemies.back());
+                enemies.pop_back();
+                continue;
             }
-            spawnQueue.pop_front();
-            spawnTimer = spawnInterval;
+            ++i;
         }
     }
-    // Check if wave is complete (all enemies dead and no pending spawns)
-    if (enemies.empty() && spawnQueue.empty() && !gameOver) {
-        waveTimer += dt;
-        if (waveTimer >= waveCooldown) {
-            currentWave++;
-            waveTimer = 0.f;
-            spawnEnemyWave(getWaveEnemyCount(currentWave));
-        }
+
+    // bucket enemies per tile for the crowd pass and the projectile sweeps below
+    {
+        TD_PROFILE_ZONE("grid");
+        enemyGrid.rebuild(enemies);
+        separateCrowd(dt);
     }
-    
-    // Update enemies (BFS-guided)
-    for (auto& e : enemies) {
-        e->update(dt);
+
+    // one ordering by path progress shared by every tower's query
+    {
+        TD_PROFILE_ZONE("progress");
+        progress.refresh();
     }
 
     // Update towers (targeting, cooldown, shooting)
-    for (auto& t : towers) {
-        t->update(dt, *this);
+    {
+        TD_PROFILE_ZONE("towers");
+        for (auto& t : towers) {
+            t->update(dt, *this);
+        }
     }
 
-    // Update projectiles (movement and collision)
-    for (auto& p : projectiles) {
-        p->update(dt);
+    // Update projectiles (movement and collision), compacting spent ones as we go
+    {
+        TD_PROFILE_ZONE("projectiles");
+        for (size_t i = 0; i < projectiles.size();) {
+            projectiles[i]->update(dt);
+            if (projectiles[i]->dead) {
+                projectilePool.push_back(std::move(projectiles[i]));
+                projectiles[i] = std::move(projectiles.back());
+                projectiles.pop_back();
+                continue;
+            }
+            ++i;
+        }
     }
 
-    // Cleanup dead objects
-    cleanupDeadStuff();
+    // Rewards, base damage and stats for everything that died this tick
+    TD_PROFILE_ZONE("deaths");
+    processDeathEvents();
 }
 
 void Game::render() {
+    TD_PROFILE_ZONE("render");
     window.clear(sf::Color::Black);
+    // world pass: everything is culled against the camera before any draw call
+    window.setView(camera);
+    sf::FloatRect visible = getVisibleWorldRect();
     map.draw(window);
+    if (showCoverage) coverage.draw(window);
     // draw spawn/base portals (vortices)
     drawPortals(window);
     
-    // Draw towers
+    // Draw towers (bounds include the range ring); on low quality levels only
+    // the ring of the tower under the cursor is drawn
+    const float hoverR = map.getTileSize() * 0.5f;
     for (auto& t : towers) {
+        sf::Vector2f p = t->getPosition();
+        t->showRange = !quality.rangeRingsOnHoverOnly() || t->getId() == selectedTowerId ||
+                       (std::abs(mouseWorld.x - p.x) < hoverR && std::abs(mouseWorld.y - p.y) < hoverR);
+        float r = t->showRange ? t->getRange() : hoverR;
+        if (!visible.intersects(sf::FloatRect(p.x - r, p.y - r, 2.f * r, 2.f * r))) continue;
         t->render(window);
     }
+    if (Tower* t = getSelectedTower()) {
+        float r = map.getTileSize() * 0.55f;
+        selectionRing.setRadius(r);
+        selectionRing.setOrigin(r, r);
+        selectionRing.setPosition(t->getPosition());
+        selectionRing.setFillColor(sf::Color::Transparent);
+        selectionRing.setOutlineThickness(2.f);
+        selectionRing.setOutlineColor(sf::Color::White);
+        window.draw(selectionRing);
+    }
     
     // Draw projectiles
+    const float margin = map.getTileSize();
     for (auto& p : projectiles) {
+        sf::Vector2f pp = p->getPosition();
+        if (pp.x < visible.left - margin || pp.y < visible.top - margin ||
+            pp.x > visible.left + visible.width + margin || pp.y > visible.top + visible.height + margin) continue;
         p->render(window);
     }
     
-    // Draw enemies
-    for (auto& e : enemies) {
-        e->render(window);
+    // Draw enemies: only the grid cells under the view (plus one for sprite overhang)
+    if (enemyGrid.items().size() != enemies.size()) enemyGrid.rebuild(enemies);
+    if (!enemies.empty()) {
+        int cx0 = enemyGrid.cellX(visible.left) - 1, cx1 = enemyGrid.cellX(visible.left + visible.width) + 1;
+        int cy0 = enemyGrid.cellY(visible.top) - 1, cy1 = enemyGrid.cellY(visible.top + visible.height) + 1;
+        cx0 = std::max(cx0, 0); cy0 = std::max(cy0, 0);
+        cx1 = std::min(cx1, enemyGrid.getCols() - 1); cy1 = std::min(cy1, enemyGrid.getRows() - 1);
+        const auto& items = enemyGrid.items();
+        const bool cheap = quality.cheapEnemies();
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                for (int k = enemyGrid.cellBegin(cx, cy); k < enemyGrid.cellEnd(cx, cy); ++k) {
+                    if (cheap) enemies[items[k]]->renderCheap(window);
+                    else enemies[items[k]]->render(window);
+                }
+            }
+        }
     }
     
+    // one batch for every particle on screen
+    particles.draw(window, visible);
+    editor.draw(window);
+
     // Draw tower placement preview
     if (placingTower) {
+        // shade every visible tile that cannot take a tower, outline the hovered one
+        const float ts = map.getTileSize();
+        int tx0 = std::max(0, static_cast<int>(visible.left / ts));
+        int ty0 = std::max(0, static_cast<int>(visible.top / ts));
+        int tx1 = std::min(map.getCols() - 1, static_cast<int>((visible.left + visible.width) / ts));
+        int ty1 = std::min(map.getRows() - 1, static_cast<int>((visible.top + visible.height) / ts));
+        sf::VertexArray shade(sf::Quads);
+        const sf::Color invalidColor(220, 40, 40, 70);
+        for (int y = ty0; y <= ty1; ++y) {
+            for (int x = tx0; x <= tx1; ++x) {
+                if (canPlaceAt(x, y) || map.getTile(x, y) == 2) continue; // walls are obvious
+                sf::Vector2f p(x * ts, y * ts);
+                shade.append(sf::Vertex(p, invalidColor));
+                shade.append(sf::Vertex(p + sf::Vector2f(ts, 0.f), invalidColor));
+                shade.append(sf::Vertex(p + sf::Vector2f(ts, ts), invalidColor));
+                shade.append(sf::Vertex(p + sf::Vector2f(0.f, ts), invalidColor));
+            }
+        }
+        if (shade.getVertexCount() > 0) window.draw(shade);
+        int hx = static_cast<int>(std::floor(previewPos.x / ts));
+        int hy = static_cast<int>(std::floor(previewPos.y / ts));
+        if (hx >= 0 && hy >= 0 && hx < map.getCols() && hy < map.getRows()) {
+            sf::RectangleShape hover({ts - 4.f, ts - 4.f});
+            hover.setPosition(hx * ts + 2.f, hy * ts + 2.f);
+            hover.setFillColor(sf::Color::Transparent);
+            hover.setOutlineThickness(2.f);
+            hover.setOutlineColor(canPlaceAt(hx, hy) ? sf::Color(60, 220, 90) : sf::Color(230, 50, 50));
+            window.draw(hover);
+        }
+
         sf::CircleShape preview(10.f);
         preview.setPosition(previewPos - sf::Vector2f(10.f, 10.f));
         
@@ -491,67 +1713,20 @@ void Game::render() {
         window.draw(preview);
     }
     
+    // screen pass: UI and overlays in window pixels
+    window.setView(uiView);
     // Draw UI
     if (ui) {
         ui->render(window);
     }
-    // If the game hasn't started yet, render a welcome/start overlay
-    if (!gameStarted) {
-        sf::RectangleShape overlay({window.getSize().x, window.getSize().y});
-        overlay.setFillColor(sf::Color(0, 0, 0, 180));
-        window.draw(overlay);
-        sf::Font font;
-        bool loaded = font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
-        if (!loaded) loaded = font.loadFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
-        sf::Text title("TOWER DEFENSE", font, 42);
-        title.setFillColor(sf::Color::White);
-        title.setPosition(window.getSize().x/2 - title.getLocalBounds().width/2, window.getSize().y*0.2f);
-        window.draw(title);
-        sf::Text startText("Press ENTER to Start", font, 26);
-        startText.setFillColor(sf::Color::Yellow);
-        startText.setPosition(window.getSize().x/2 - startText.getLocalBounds().width/2, window.getSize().y*0.6f);
-        window.draw(startText);
-    }
-
-    // If game is over, show Game Over overlay and option to restart
-    if (gameOver) {
-        sf::RectangleShape overlay({window.getSize().x, window.getSize().y});
-        overlay.setFillColor(sf::Color(0, 0, 0, 200));
-        window.draw(overlay);
-        sf::Font font;
-        bool loaded = font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
-        if (!loaded) loaded = font.loadFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
-        sf::Text overText("GAME OVER", font, 64);
-        overText.setFillColor(sf::Color::Red);
-        overText.setPosition(window.getSize().x/2 - overText.getLocalBounds().width/2, window.getSize().y*0.2f);
-        window.draw(overText);
-        sf::Text restartText("Press ENTER to Restart", font, 26);
-        restartText.setFillColor(sf::Color::White);
-        restartText.setPosition(window.getSize().x/2 - restartText.getLocalBounds().width/2, window.getSize().y*0.6f);
-        window.draw(restartText);
-    }
-
-    window.display();
+    // start menu / game over screens
+    if (ui) ui->renderOverlay(window);
 }
 
 void Game::drawPortals(sf::RenderWindow& window) {
-    // draw portals at spawn tile (spawnTileX/Y) and base tile
+    // draw portals at every spawn tile and base tile
     float ts = map.getTileSize();
-    auto base = map.findBase();
-    std::vector<std::pair<sf::Vector2f, sf::Color>> portals;
-    if (spawnTileX >= 0 && spawnTileY >= 0) {
-        portals.push_back({map.tileCenter(spawnTileX, spawnTileY), sf::Color(200,50,50)}); // red spawn
-    } else {
-        // try to find spawn tile by scanning
-        for (int y=0; y<map.getRows(); ++y) {
-            for (int x=0; x<map.getCols(); ++x) {
-                if (map.getTile(x,y) == 4) portals.push_back({map.tileCenter(x,y), sf::Color(200,50,50)});
-            }
-        }
-    }
-    if (base.first != -1 && base.second != -1) {
-        portals.push_back({map.tileCenter(base.first, base.second), sf::Color(70,130,180)}); // blue base
-    }
+    TD_PROFILE_ZONE("portals");
 
     auto hsv2rgb = [](float h, float s, float v) -> sf::Color {
         while (h < 0) h += 360.f;
@@ -574,22 +1749,29 @@ void Game::drawPortals(sf::RenderWindow& window) {
         return sf::Color(R, G, B);
     };
 
-    for (auto &p : portals) {
-        sf::Vector2f center = p.first;
-        sf::Color color = p.second;
-        float baseHue = (color.r > color.b) ? 20.f : 220.f;
+    sf::FloatRect visible = getVisibleWorldRect();
+    // the shapes are members reused for every ring/arm: building SFML shapes
+    // allocates their vertex storage, resizing them in place does not
+    sf::CircleShape& ring = portalRing;
+    sf::CircleShape& centerDisc = portalDisc;
+    sf::ConvexShape& wedge = portalArm;
+    // fewer rings and arms on lower quality levels
+    const int rings = quality.portalRings(), arms = quality.portalArms();
+    // spawns are red-orange, bases blue
+    auto drawPortal = [&](sf::Vector2f center, bool spawn) {
+        // arms reach about one tile out from the center
+        if (!visible.intersects(sf::FloatRect(center.x - ts, center.y - ts, 2.f * ts, 2.f * ts))) return;
+        float baseHue = spawn ? 20.f : 220.f;
         float portalOffset = (center.x + center.y) * 0.123f;
-        for (int i = 0; i < 6; ++i) {
+        float localPulse = spawn ? spawnPortalPulse.at(simTime) : basePortalPulse.at(simTime);
+        for (int i = 0; i < rings; ++i) {
             float radius = ts * (0.18f + i * 0.12f);
-            sf::CircleShape ring(radius);
+            ring.setRadius(radius);
             ring.setOrigin(radius, radius);
             ring.setPosition(center);
             ring.setFillColor(sf::Color::Transparent);
             float thickness = ts * (0.06f + i * 0.02f);
             ring.setOutlineThickness(thickness);
-            float localPulse = 0.f;
-            if (color.r > color.b) localPulse = spawnPortalPulse;
-            else localPulse = basePortalPulse;
             int alpha = static_cast<int>(140 + 120 * std::sin(portalAnimTime * (0.8f + i*0.4f) + portalOffset) + 80 * localPulse);
             alpha = std::clamp(alpha, 50, 255);
             float hue = baseHue + 20.f * std::sin(portalAnimTime * 0.7f + i * 0.3f + portalOffset);
@@ -602,7 +1784,7 @@ void Game::drawPortals(sf::RenderWindow& window) {
             window.draw(ring);
         }
         float radiusC = ts * (0.14f + 0.12f * localPulse);
-        sf::CircleShape centerDisc(radiusC);
+        centerDisc.setRadius(radiusC);
         centerDisc.setOrigin(radiusC, radiusC);
         centerDisc.setPosition(center);
         int alphaC = static_cast<int>(200 + 55 * std::sin(portalAnimTime * 2.2f));
@@ -614,14 +1796,13 @@ void Game::drawPortals(sf::RenderWindow& window) {
         fill.b = std::min(255, fill.b + 20);
         centerDisc.setFillColor(fill);
         window.draw(centerDisc);
-        int nArms = 7;
+        int nArms = arms;
         float armLen = ts * 0.85f;
         float armWidth = ts * 0.08f;
         for (int a = 0; a < nArms; ++a) {
             float t = portalAnimTime * 1.4f + a * (2 * 3.14159f / nArms);
             float angleDeg = std::fmod(t, 2*3.14159f) * 180.f / 3.14159f;
             float rInner = ts * 0.2f + 0.08f * ts * std::sin(t * 0.6f + a);
-            sf::ConvexShape wedge;
             wedge.setPointCount(3);
             wedge.setPoint(0, sf::Vector2f(0.f, 0.f));
             wedge.setPoint(1, sf::Vector2f(armLen, -armWidth));
@@ -635,5 +1816,8 @@ void Game::drawPortals(sf::RenderWindow& window) {
             wedge.setFillColor(armColor);
             window.draw(wedge);
         }
-    }
+    };
+    const auto& spawns = spawnPoints.empty() ? map.getSpawns() : spawnPoints;
+    for (const auto& sp : spawns) drawPortal(map.tileCenter(sp.x, sp.y), true);
+    for (const auto& b : map.getBases()) drawPortal(map.tileCenter(b.x, b.y), false);
 }
@@ -1,5 +1,7 @@
 #include "GameUI.h"
 #include "Game.h"
+#include "AllocTracker.h"
+#include <cstdio>
 
 GameUI::GameUI(const Game* g) : game(g) {
     // Try to load a font (optional - if it fails, we just won't render text)
@@ -8,6 +10,38 @@ GameUI::GameUI(const Game* g) : game(g) {
     if (!fontLoaded) {
         fontLoaded = font.loadFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
     }
+
+    auto setup = [this](sf::Text& t, unsigned size, const sf::Color& color) {
+        t.setFont(font);
+        t.setCharacterSize(size);
+        t.setFillColor(color);
+    };
+    setup(healthText, 16, sf::Color::White);
+    setup(waveText, 16, sf::Color::White);
+    setup(moneyText, 20, sf::Color::Yellow);
+    setup(controlsText, 14, sf::Color::Green);
+    setup(towerText, 16, sf::Color::Cyan);
+    setup(gameOverText, 30, sf::Color::Red);
+    setup(pausedText, 30, sf::Color::White);
+    setup(debugText, 13, sf::Color(180, 255, 180));
+    setup(speedText, 18, sf::Color::White);
+    setup(menuTitle, 42, sf::Color::White);
+    setup(menuStart, 26, sf::Color::Yellow);
+    setup(overTitle, 64, sf::Color::Red);
+    setup(overRestart, 26, sf::Color::White);
+    setup(menuWaiting, 26, sf::Color::Yellow);
+    setup(netText, 16, sf::Color::White);
+    setup(selectionText, 16, sf::Color(255, 230, 120));
+    setup(coverageText, 16, sf::Color::Cyan);
+    setup(editorText, 16, sf::Color::White);
+    menuTitle.setString("TOWER DEFENSE");
+    menuStart.setString("Press ENTER to Start");
+    overTitle.setString("GAME OVER");
+    overRestart.setString("Press ENTER to Restart");
+    menuWaiting.setString("Waiting for the other player...");
+    controlsText.setString("1=Sniper 2=Freeze 3=Cannon ESC=Cancel H=Coverage E=Editor");
+    gameOverText.setString("GAME OVER!");
+    pausedText.setString("PAUSED");
 }
 
 std::string GameUI::getTowerName(int type) const {
@@ -30,71 +64,209 @@ int GameUI::getTowerCost(int type) const {
 
 void GameUI::render(sf::RenderWindow& window) {
     if (!fontLoaded) return;  // Skip text rendering if font not loaded
-    
-    // Prepare text settings
-    sf::Text text;
-    text.setFont(font);
-    text.setCharacterSize(16);
-    text.setFillColor(sf::Color::White);
+    TD_PROFILE_ZONE("ui");
     
     // === Top-left: Player health ===
-    text.setString("Health: " + std::to_string(game->playerHealth));
-    text.setPosition(10.f, 10.f);
-    window.draw(text);
+    if (game->playerHealth != shownHealth) {
+        shownHealth = game->playerHealth;
+        healthText.setString("Health: " + std::to_string(shownHealth));
+    }
+    healthText.setPosition(10.f, 10.f);
+    window.draw(healthText);
     
     // === Top-left +25: Wave info ===
-    text.setString("Wave: " + std::to_string(game->currentWave) + 
-                   " Enemies: " + std::to_string(game->enemies.size()));
-    text.setPosition(10.f, 35.f);
-    window.draw(text);
+    if (game->currentWave != shownWave || game->liveEnemies != shownEnemies) {
+        shownWave = game->currentWave;
+        shownEnemies = game->liveEnemies;
+        waveText.setString("Wave: " + std::to_string(shownWave) + 
+                           " Enemies: " + std::to_string(shownEnemies));
+    }
+    waveText.setPosition(10.f, 35.f);
+    window.draw(waveText);
     
     // === Top-left +50: Money ===
-    text.setCharacterSize(20);
-    text.setFillColor(sf::Color::Yellow);
-    text.setString("Money: $" + std::to_string(game->money));
-    text.setPosition(10.f, 60.f);
-    window.draw(text);
+    if (game->money != shownMoney) {
+        shownMoney = game->money;
+        moneyText.setString("Money: $" + std::to_string(shownMoney));
+    }
+    moneyText.setPosition(10.f, 60.f);
+    window.draw(moneyText);
     
     // === Top-right: Controls ===
-    text.setCharacterSize(14);
-    text.setFillColor(sf::Color::Green);
-    text.setString("1=Sniper 2=Freeze 3=Cannon ESC=Cancel");
-    text.setPosition(window.getSize().x - 350.f, 10.f);
-    window.draw(text);
+    controlsText.setPosition(window.getSize().x - 350.f, 10.f);
+    window.draw(controlsText);
     
     // === Top-right tower info ===
     if (game->placingTower) {
-        text.setCharacterSize(16);
-        text.setFillColor(sf::Color::Cyan);
-        
-        std::string towerName = getTowerName(game->selectedTowerType);
         int cost = getTowerCost(game->selectedTowerType);
-        
-        std::string infoStr = towerName + " - Cost: $" + std::to_string(cost);
-        if (game->money < cost) {
-            infoStr += " (NOT ENOUGH!)";
+        bool affordable = game->money >= cost;
+        if (game->selectedTowerType != shownTowerType || affordable != shownAffordable) {
+            shownTowerType = game->selectedTowerType;
+            shownAffordable = affordable;
+            std::string infoStr = getTowerName(shownTowerType) + " - Cost: $" + std::to_string(cost);
+            if (!affordable) {
+                infoStr += " (NOT ENOUGH!)";
+            }
+            towerText.setString(infoStr);
+        }
+        towerText.setPosition(window.getSize().x - 350.f, 35.f);
+        window.draw(towerText);
+
+        // fire already reaching the tile under the cursor
+        float ts = game->getMap().getTileSize();
+        int tx = static_cast<int>(game->previewPos.x / ts), ty = static_cast<int>(game->previewPos.y / ts);
+        int covered = game->coverage.coverageAt(tx, ty);
+        int dps = static_cast<int>(game->coverage.dpsAt(tx, ty) + 0.5f);
+        if (covered != shownCoverage || dps != shownCoverageDps) {
+            shownCoverage = covered;
+            shownCoverageDps = dps;
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "Here: %d tower%s, %d dps", covered, covered == 1 ? "" : "s", dps);
+            coverageText.setString(buf);
         }
-        
-        text.setString(infoStr);
-        text.setPosition(window.getSize().x - 350.f, 35.f);
-        window.draw(text);
+        coverageText.setPosition(window.getSize().x - 350.f, 110.f);
+        window.draw(coverageText);
     }
     
+    // === Top-right: fast-forward speed, and what is actually achieved when behind ===
+    if (game->getSimSpeed() > 1) {
+        int achieved = game->isSimBehind() ? static_cast<int>(game->effectiveSpeed * 10.f + 0.5f) : -1;
+        if (game->getSimSpeed() != shownSpeed || achieved != shownAchieved) {
+            shownSpeed = game->getSimSpeed();
+            shownAchieved = achieved;
+            char buf[48];
+            if (achieved < 0) std::snprintf(buf, sizeof(buf), ">> x%d", shownSpeed);
+            else std::snprintf(buf, sizeof(buf), ">> x%d (running x%d.%d)", shownSpeed, achieved / 10, achieved % 10);
+            speedText.setString(buf);
+            speedText.setFillColor(achieved < 0 ? sf::Color::White : sf::Color(255, 140, 0));
+        }
+        speedText.setPosition(window.getSize().x - 350.f, 60.f);
+        window.draw(speedText);
+    }
+
+    // === Top-right: co-op link ===
+    if (game->net) {
+        const Lockstep& net = *game->net;
+        int state = net.isDesynced() ? 3 : net.isPeerLost() ? 2 : game->netStallFrames > 15 ? 1 : 0;
+        if (state != shownNetState) {
+            shownNetState = state;
+            char buf[64];
+            switch (state) {
+                case 3: std::snprintf(buf, sizeof(buf), "CO-OP: DESYNC at tick %lld", net.getDesyncTick()); break;
+                case 2: std::snprintf(buf, sizeof(buf), "CO-OP: other player lost"); break;
+                case 1: std::snprintf(buf, sizeof(buf), "CO-OP P%d: waiting for the other player", net.getPlayer() + 1); break;
+                default: std::snprintf(buf, sizeof(buf), "CO-OP P%d (input delay %d)", net.getPlayer() + 1, net.getInputDelay()); break;
+            }
+            netText.setString(buf);
+            netText.setFillColor(state >= 2 ? sf::Color::Red : state == 1 ? sf::Color(255, 140, 0) : sf::Color::White);
+        }
+        netText.setPosition(window.getSize().x - 350.f, 85.f);
+        window.draw(netText);
+    }
+
+    // === Top-left +85: selected tower ===
+    if (const Tower* t = game->getSelectedTower()) {
+        int policy = static_cast<int>(t->getPolicy());
+        if (t->getId() != shownSelected || policy != shownPolicy || t->getKills() != shownKills ||
+            t->getLevel() != shownLevel) {
+            shownSelected = t->getId();
+            shownPolicy = policy;
+            shownKills = t->getKills();
+            shownLevel = t->getLevel();
+            char buf[160];
+            std::snprintf(buf, sizeof(buf), "Tower #%d L%d - target: %s (T) - kills: %d\nU: upgrade $%d - Del: sell $%d",
+                          shownSelected, shownLevel, targetPolicyName(t->getPolicy()), shownKills,
+                          t->getUpgradeCost(), t->getSellValue());
+            selectionText.setString(buf);
+        }
+        selectionText.setPosition(10.f, 85.f);
+        window.draw(selectionText);
+    }
+
     // === Bottom-left: Game over message ===
     if (game->gameOver) {
-        text.setCharacterSize(30);
-        text.setFillColor(sf::Color::Red);
-        text.setString("GAME OVER!");
-        text.setPosition(window.getSize().x / 2.f - 100.f, window.getSize().y / 2.f);
-        window.draw(text);
+        gameOverText.setPosition(window.getSize().x / 2.f - 100.f, window.getSize().y / 2.f);
+        window.draw(gameOverText);
     }
     
+    // === Top-left +85: map editor (the match is paused meanwhile) ===
+    const MapEditor& ed = game->editor;
+    if (ed.isActive()) {
+        if (ed.getRevision() != shownEditor) {
+            shownEditor = ed.getRevision();
+            static const char* const tileNames[] = {"Grass", "Path", "Wall", "Base", "Spawn"};
+            const Map& m = game->getMap();
+            char buf[256];
+            int n = std::snprintf(buf, sizeof(buf), "EDITOR - brush: %s, radius %d\n1-5: tile  [ ]: size  right: erase  Ctrl+S: save  E: quit\n",
+                                  tileNames[ed.getBrush()], ed.getRadius());
+            if (m.getBases().empty()) std::snprintf(buf + n, sizeof(buf) - n, "No base");
+            else if (m.getSpawns().empty()) std::snprintf(buf + n, sizeof(buf) - n, "No spawn");
+            else if (ed.getCutSpawns() > 0) std::snprintf(buf + n, sizeof(buf) - n, "%d spawn%s cut off from the bases", ed.getCutSpawns(), ed.getCutSpawns() == 1 ? "" : "s");
+            else std::snprintf(buf + n, sizeof(buf) - n, "OK: every spawn reaches a base");
+            std::string text = buf;
+            if (!ed.getStatus().empty()) text += "\n" + ed.getStatus();
+            editorText.setString(text);
+            editorText.setFillColor(ed.isValid() ? sf::Color::White : sf::Color(255, 120, 90));
+        }
+        editorText.setPosition(10.f, 85.f);
+        window.draw(editorText);
+    }
+
     // === Paused message ===
-    if (game->paused) {
-        text.setCharacterSize(30);
-        text.setFillColor(sf::Color::White);
-        text.setString("PAUSED");
-        text.setPosition(window.getSize().x / 2.f - 60.f, window.getSize().y / 2.f - 40.f);
-        window.draw(text);
+    if (game->paused && !ed.isActive()) {
+        pausedText.setPosition(window.getSize().x / 2.f - 60.f, window.getSize().y / 2.f - 40.f);
+        window.draw(pausedText);
     }
+
+    if (game->showDebug) renderDebug(window);
+}
+
+void GameUI::renderDebug(sf::RenderWindow& window) {
+    // rebuilt a few times per second: the overlay itself should barely show up
+    // in the counters it displays
+    debugRefresh -= game->frameTime;
+    if (debugRefresh <= 0.f) {
+        debugRefresh = 0.25f;
+        char buf[1024];
+        int n = std::snprintf(buf, sizeof(buf), "frame %.2f ms  enemies %zu  projectiles %zu\n",
+                              game->frameTime * 1000.f, game->enemies.size(), game->projectiles.size());
+        const ParticleSystem& ps = game->particles;
+        n += std::snprintf(buf + n, sizeof(buf) - n, "particles %d / %d  dropped %llu\n", ps.getCount(), ps.getBudget(),
+                           static_cast<unsigned long long>(ps.getDropped() - shownDropped));
+        shownDropped = ps.getDropped();
+        const QualityGovernor& q = game->quality;
+        n += std::snprintf(buf + n, sizeof(buf) - n, "quality %d%s  work %.2f / %.2f ms\n", q.getLevel(),
+                           q.isEnabled() ? " (auto)" : " (F4: off)", q.getAverage() * 1000.f, q.getBudget() * 1000.f);
+        if (!AllocTracker::enabled) {
+            n += std::snprintf(buf + n, sizeof(buf) - n, "allocs: build with TD_TRACK_ALLOCS");
+        } else {
+            const AllocTracker::Counts& f = AllocTracker::lastFrame();
+            n += std::snprintf(buf + n, sizeof(buf) - n, "allocs/frame %llu (%llu B)  frees %llu",
+                               static_cast<unsigned long long>(f.allocs), static_cast<unsigned long long>(f.bytes),
+                               static_cast<unsigned long long>(f.frees));
+            for (int z = 0; z < AllocTracker::zoneCount() && n < static_cast<int>(sizeof(buf)) - 64; ++z) {
+                const AllocTracker::Counts& zc = AllocTracker::zoneLastFrame(z);
+                n += std::snprintf(buf + n, sizeof(buf) - n, "\n  %-12s %llu (%llu B)", AllocTracker::zoneName(z),
+                                   static_cast<unsigned long long>(zc.allocs), static_cast<unsigned long long>(zc.bytes));
+            }
+        }
+        debugText.setString(buf);
+    }
+    debugText.setPosition(10.f, 90.f);
+    window.draw(debugText);
+}
+
+void GameUI::renderOverlay(sf::RenderWindow& window) {
+    if (game->gameStarted && !game->gameOver) return;
+    sf::Vector2f size(static_cast<float>(window.getSize().x), static_cast<float>(window.getSize().y));
+    sf::RectangleShape overlay(size);
+    overlay.setFillColor(sf::Color(0, 0, 0, game->gameOver ? 200 : 180));
+    window.draw(overlay);
+    if (!fontLoaded) return;
+    sf::Text& title = game->gameOver ? overTitle : menuTitle;
+    sf::Text& prompt = game->gameOver ? (game->net ? netText : overRestart) : (game->net ? menuWaiting : menuStart);
+    title.setPosition(size.x / 2.f - title.getLocalBounds().width / 2.f, size.y * 0.2f);
+    prompt.setPosition(size.x / 2.f - prompt.getLocalBounds().width / 2.f, size.y * 0.6f);
+    window.draw(title);
+    window.draw(prompt);
 }
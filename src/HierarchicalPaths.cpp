@@ -0,0 +1,378 @@
+#include "HierarchicalPaths.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+void HierarchicalPaths::clear() {
+    cols = rows = ccols = crows = 0;
+    open.clear();
+    nodes.clear();
+    freeNodes.clear();
+    clusters.clear();
+    vBorders.clear();
+    hBorders.clear();
+    absDist.clear();
+    parent.clear();
+    stagedClusters.clear();
+    stagedBorders.clear();
+    clusterStaged.clear();
+    borderStaged.clear();
+}
+
+void HierarchicalPaths::build(int c, int r, const std::vector<std::uint8_t>& openTiles, const std::vector<sf::Vector2i>& bases) {
+    clear();
+    if (c <= 0 || r <= 0 || openTiles.size() < static_cast<size_t>(c * r)) return;
+    cols = c;
+    rows = r;
+    open = openTiles;
+    ccols = (cols + clusterSize - 1) / clusterSize;
+    crows = (rows + clusterSize - 1) / clusterSize;
+    clusters.resize(ccols * crows);
+    for (int cy = 0; cy < crows; ++cy) {
+        for (int cx = 0; cx < ccols; ++cx) {
+            Cluster& cl = clusters[cy * ccols + cx];
+            cl.x0 = cx * clusterSize;
+            cl.y0 = cy * clusterSize;
+            cl.w = std::min(clusterSize, cols - cl.x0);
+            cl.h = std::min(clusterSize, rows - cl.y0);
+        }
+    }
+    vBorders.assign(ccols * crows, {});
+    hBorders.assign(ccols * crows, {});
+    clusterStaged.assign(ccols * crows, 0);
+    borderStaged.assign(ccols * crows, 0);
+    for (int cy = 0; cy < crows; ++cy) {
+        for (int cx = 0; cx < ccols; ++cx) {
+            if (cx + 1 < ccols) rebuildBorder(true, cx, cy);
+            if (cy + 1 < crows) rebuildBorder(false, cx, cy);
+        }
+    }
+    // bases are goal nodes without a partner
+    for (const auto& b : bases) {
+        if (b.x >= 0 && b.y >= 0 && b.x < cols && b.y < rows) allocNode(b.x, b.y, -1);
+    }
+    for (size_t i = 0; i < clusters.size(); ++i) rebuildIntra(static_cast<int>(i));
+    searchAbstract();
+}
+
+int HierarchicalPaths::allocNode(int x, int y, int partner) {
+    int id;
+    if (!freeNodes.empty()) {
+        id = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        id = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& n = nodes[id];
+    n.x = x;
+    n.y = y;
+    n.cluster = clusterOf(x, y);
+    n.partner = partner;
+    n.alive = true;
+    clusters[n.cluster].nodes.push_back(id);
+    return id;
+}
+
+void HierarchicalPaths::freeNode(int id) {
+    Node& n = nodes[id];
+    auto& list = clusters[n.cluster].nodes;
+    list.erase(std::find(list.begin(), list.end(), id));
+    n.alive = false;
+    freeNodes.push_back(id);
+}
+
+void HierarchicalPaths::rebuildBorder(bool vertical, int cx, int cy) {
+    auto& portals = (vertical ? vBorders : hBorders)[cy * ccols + cx];
+    for (int id : portals) freeNode(id);
+    portals.clear();
+
+    // scan the two facing lines of tiles for runs that are open on both sides
+    const Cluster& cl = clusters[cy * ccols + cx];
+    int len = vertical ? cl.h : cl.w;
+    auto tileA = [&](int i) { return vertical ? sf::Vector2i(cl.x0 + cl.w - 1, cl.y0 + i) : sf::Vector2i(cl.x0 + i, cl.y0 + cl.h - 1); };
+    auto tileB = [&](int i) { sf::Vector2i a = tileA(i); return vertical ? sf::Vector2i(a.x + 1, a.y) : sf::Vector2i(a.x, a.y + 1); };
+    auto addPair = [&](int i) {
+        sf::Vector2i a = tileA(i), b = tileB(i);
+        int na = allocNode(a.x, a.y, -1);
+        int nb = allocNode(b.x, b.y, na);
+        nodes[na].partner = nb;
+        portals.push_back(na);
+        portals.push_back(nb);
+    };
+    int runStart = -1;
+    for (int i = 0; i <= len; ++i) {
+        bool both = false;
+        if (i < len) {
+            sf::Vector2i a = tileA(i), b = tileB(i);
+            both = isOpen(a.x, a.y) && isOpen(b.x, b.y);
+        }
+        if (both && runStart < 0) runStart = i;
+        if (!both && runStart >= 0) {
+            // short entrances get one portal in the middle, long ones one at each end
+            int runLen = i - runStart;
+            if (runLen < 6) {
+                addPair(runStart + runLen / 2);
+            } else {
+                addPair(runStart);
+                addPair(i - 1);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void HierarchicalPaths::rebuildIntra(int c) {
+    Cluster& cl = clusters[c];
+    cl.fieldValid = false;
+    size_t k = cl.nodes.size();
+    cl.cost.assign(k * k, -1);
+    for (size_t i = 0; i < k; ++i) nodes[cl.nodes[i]].slot = static_cast<int>(i);
+    if (k == 0) return;
+
+    // one BFS per node, confined to the cluster
+    const int area = cl.w * cl.h;
+    std::vector<int> dist(area);
+    std::vector<int> queue(area);
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    for (size_t i = 0; i < k; ++i) {
+        const Node& src = nodes[cl.nodes[i]];
+        std::fill(dist.begin(), dist.end(), -1);
+        int head = 0, tail = 0;
+        int s = (src.y - cl.y0) * cl.w + (src.x - cl.x0);
+        dist[s] = 0;
+        queue[tail++] = s;
+        while (head < tail) {
+            int cur = queue[head++];
+            int lx = cur % cl.w, ly = cur / cl.w;
+            for (int d = 0; d < 4; ++d) {
+                int nx = lx + dx[d], ny = ly + dy[d];
+                if (nx < 0 || ny < 0 || nx >= cl.w || ny >= cl.h) continue;
+                int ni = ny * cl.w + nx;
+                if (dist[ni] != -1 || !isOpen(cl.x0 + nx, cl.y0 + ny)) continue;
+                dist[ni] = dist[cur] + 1;
+                queue[tail++] = ni;
+            }
+        }
+        for (size_t j = 0; j < k; ++j) {
+            const Node& dst = nodes[cl.nodes[j]];
+            cl.cost[i * k + j] = dist[(dst.y - cl.y0) * cl.w + (dst.x - cl.x0)];
+        }
+    }
+}
+
+template <class F>
+void HierarchicalPaths::forEachNeighbor(int id, F&& f) const {
+    const Node& n = nodes[id];
+    const Cluster& cl = clusters[n.cluster];
+    size_t k = cl.nodes.size();
+    for (size_t j = 0; j < k; ++j) {
+        int c = cl.cost[n.slot * k + j];
+        if (c >= 0 && cl.nodes[j] != id) f(cl.nodes[j], c);
+    }
+    if (n.partner >= 0) f(n.partner, 1);
+}
+
+void HierarchicalPaths::searchAbstract() {
+    absDist.assign(nodes.size(), Unreached);
+    parent.assign(nodes.size(), -1);
+    using Item = std::pair<int, int>; // (distance, node)
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        // bases are the only nodes without a partner
+        if (nodes[i].alive && nodes[i].partner < 0) {
+            absDist[i] = 0;
+            pq.push({0, static_cast<int>(i)});
+        }
+    }
+    while (!pq.empty()) {
+        auto [d, id] = pq.top();
+        pq.pop();
+        if (d != absDist[id]) continue;
+        forEachNeighbor(id, [&](int to, int c) {
+            if (d + c < absDist[to]) {
+                absDist[to] = d + c;
+                parent[to] = id;
+                pq.push({d + c, to});
+            }
+        });
+    }
+    for (auto& cl : clusters) cl.fieldValid = false;
+}
+
+void HierarchicalPaths::repairAbstract(const int* touched, int count) {
+    // node ids may have grown while rebuilding borders
+    absDist.resize(nodes.size(), Unreached);
+    parent.resize(nodes.size(), -1);
+
+    // 1. every node of a rebuilt cluster, and everything whose tree path runs
+    //    through one, loses its distance (it can only be trusted again once
+    //    re-derived from an untouched neighbor)
+    std::vector<std::pair<int, int>> changed; // (node, old distance)
+    std::vector<int> stack;
+    auto invalidate = [&](int id) {
+        changed.push_back({id, absDist[id]});
+        absDist[id] = Unreached;
+        parent[id] = -1;
+        stack.push_back(id);
+    };
+    for (int t = 0; t < count; ++t) {
+        for (int id : clusters[touched[t]].nodes) {
+            if (absDist[id] != Unreached || parent[id] != -1) invalidate(id);
+            else changed.push_back({id, Unreached});
+        }
+    }
+    for (size_t i = 0; i < stack.size(); ++i) {
+        int u = stack[i];
+        forEachNeighbor(u, [&](int v, int) {
+            if (parent[v] == u && absDist[v] != Unreached) invalidate(v);
+        });
+    }
+
+    // 2. seed the invalidated nodes from their best still-valid neighbor, then
+    //    a Dijkstra relaxes outward (this also carries any decrease onward)
+    using Item = std::pair<int, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+    for (const auto& [id, old] : changed) {
+        if (!nodes[id].alive || absDist[id] != Unreached) continue;
+        if (nodes[id].partner < 0) {
+            absDist[id] = 0;
+        } else {
+            forEachNeighbor(id, [&](int w, int c) {
+                if (absDist[w] != Unreached && absDist[w] + c < absDist[id]) {
+                    absDist[id] = absDist[w] + c;
+                    parent[id] = w;
+                }
+            });
+        }
+        if (absDist[id] != Unreached) pq.push({absDist[id], id});
+    }
+    while (!pq.empty()) {
+        auto [d, id] = pq.top();
+        pq.pop();
+        if (d != absDist[id]) continue;
+        forEachNeighbor(id, [&](int to, int c) {
+            if (d + c < absDist[to]) {
+                if (changed.empty() || changed.back().first != to) changed.push_back({to, absDist[to]});
+                absDist[to] = d + c;
+                parent[to] = id;
+                pq.push({d + c, to});
+            }
+        });
+    }
+
+    // 3. only clusters where a node distance actually moved refill their tiles
+    for (const auto& [id, old] : changed) {
+        if (nodes[id].alive && absDist[id] != old) clusters[nodes[id].cluster].fieldValid = false;
+    }
+}
+
+void HierarchicalPaths::setOpen(int tx, int ty, bool o) {
+    stageOpen(tx, ty, o);
+    commit();
+}
+
+void HierarchicalPaths::stageCluster(int c) {
+    if (clusterStaged[c]) return;
+    clusterStaged[c] = 1;
+    stagedClusters.push_back(c);
+}
+
+void HierarchicalPaths::stageBorder(bool vertical, int c) {
+    // the border between c and its right (vertical) or lower neighbor
+    if (!borderStaged[c]) stagedBorders.push_back(c);
+    borderStaged[c] |= vertical ? 1 : 2;
+    stageCluster(c);
+    stageCluster(vertical ? c + 1 : c + ccols);
+}
+
+void HierarchicalPaths::stageOpen(int tx, int ty, bool o) {
+    if (tx < 0 || ty < 0 || tx >= cols || ty >= rows) return;
+    if (isOpen(tx, ty) == o) return;
+    open[ty * cols + tx] = o ? 1 : 0;
+
+    int cx = tx / clusterSize, cy = ty / clusterSize;
+    int c = cy * ccols + cx;
+    const Cluster& cl = clusters[c];
+    stageCluster(c);
+    // border tiles also change the portals shared with the neighbor cluster
+    if (tx == cl.x0 && cx > 0) stageBorder(true, c - 1);
+    if (tx == cl.x0 + cl.w - 1 && cx + 1 < ccols) stageBorder(true, c);
+    if (ty == cl.y0 && cy > 0) stageBorder(false, c - ccols);
+    if (ty == cl.y0 + cl.h - 1 && cy + 1 < crows) stageBorder(false, c);
+}
+
+void HierarchicalPaths::stageBase(int tx, int ty, bool base) {
+    if (tx < 0 || ty < 0 || tx >= cols || ty >= rows) return;
+    int c = clusterOf(tx, ty);
+    // bases are the only nodes without a partner
+    int found = -1;
+    for (int id : clusters[c].nodes) {
+        if (nodes[id].partner < 0 && nodes[id].x == tx && nodes[id].y == ty) found = id;
+    }
+    if (base == (found >= 0)) return;
+    if (base) allocNode(tx, ty, -1);
+    else freeNode(found);
+    stageCluster(c);
+}
+
+void HierarchicalPaths::commit() {
+    if (stagedClusters.empty()) return;
+    for (int c : stagedBorders) {
+        if (borderStaged[c] & 1) rebuildBorder(true, c % ccols, c / ccols);
+        if (borderStaged[c] & 2) rebuildBorder(false, c % ccols, c / ccols);
+        borderStaged[c] = 0;
+    }
+    for (int c : stagedClusters) {
+        rebuildIntra(c);
+        clusterStaged[c] = 0;
+    }
+    repairAbstract(stagedClusters.data(), static_cast<int>(stagedClusters.size()));
+    stagedBorders.clear();
+    stagedClusters.clear();
+}
+
+int HierarchicalPaths::distanceAt(int tx, int ty) const {
+    if (tx < 0 || ty < 0 || tx >= cols || ty >= rows || !isOpen(tx, ty)) return -1;
+    const Cluster& cl = clusters[clusterOf(tx, ty)];
+    if (!cl.fieldValid) fillField(cl);
+    return cl.field[(ty - cl.y0) * cl.w + (tx - cl.x0)];
+}
+
+void HierarchicalPaths::fillField(const Cluster& cl) const {
+    // Dijkstra inside the cluster seeded with the abstract distance of its nodes;
+    // steps are unit cost so sorted seeds + a FIFO merge would also do, but the
+    // heap keeps it simple at cluster scale
+    cl.field.assign(cl.w * cl.h, Unreached);
+    using Item = std::pair<int, int>; // (distance, local tile)
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+    for (int id : cl.nodes) {
+        int d = absDist[id];
+        if (d == Unreached) continue;
+        int li = (nodes[id].y - cl.y0) * cl.w + (nodes[id].x - cl.x0);
+        if (d < cl.field[li]) {
+            cl.field[li] = d;
+            pq.push({d, li});
+        }
+    }
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    while (!pq.empty()) {
+        auto [d, li] = pq.top();
+        pq.pop();
+        if (d != cl.field[li]) continue;
+        int lx = li % cl.w, ly = li / cl.w;
+        for (int k = 0; k < 4; ++k) {
+            int nx = lx + dx[k], ny = ly + dy[k];
+            if (nx < 0 || ny < 0 || nx >= cl.w || ny >= cl.h) continue;
+            int ni = ny * cl.w + nx;
+            if (!isOpen(cl.x0 + nx, cl.y0 + ny) || d + 1 >= cl.field[ni]) continue;
+            cl.field[ni] = d + 1;
+            pq.push({d + 1, ni});
+        }
+    }
+    for (int& v : cl.field) if (v == Unreached) v = -1;
+    cl.fieldValid = true;
+}
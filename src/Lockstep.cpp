@@ -0,0 +1,300 @@
+#include "Lockstep.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// packet header: magic, version, kind, player, input delay, seed
+constexpr std::uint8_t Magic0 = 'T', Magic1 = 'D', Version = 3; // 2: SetPolicy, 3: upgrade and sell
+enum PacketKind : std::uint8_t { Hello = 0, Data = 1 };
+constexpr std::size_t MaxPacket = 1024;
+const sf::Time HelloInterval = sf::milliseconds(100);
+const sf::Time PeerTimeout = sf::seconds(5.f);
+
+// little-endian, bounds-checked both ways
+struct Writer {
+    std::uint8_t* p;
+    std::size_t size = 0, cap;
+    void u8(std::uint8_t v) { if (size < cap) p[size++] = v; }
+    void u16(std::uint16_t v) { u8(v & 0xff); u8(v >> 8); }
+    void u32(std::uint32_t v) { u16(v & 0xffff); u16(v >> 16); }
+};
+
+struct Reader {
+    const std::uint8_t* p;
+    std::size_t size, pos = 0;
+    bool ok = true;
+    std::uint8_t u8() {
+        if (pos >= size) { ok = false; return 0; }
+        return p[pos++];
+    }
+    std::uint16_t u16() { std::uint16_t lo = u8(); return static_cast<std::uint16_t>(lo | (u8() << 8)); }
+    std::uint32_t u32() { std::uint32_t lo = u16(); return lo | (static_cast<std::uint32_t>(u16()) << 16); }
+};
+
+constexpr std::size_t CommandSize = 7;
+}
+
+void Lockstep::resetTicks() {
+    // frames below inputDelay are empty on both sides: nobody could have
+    // issued anything for them
+    localNext = remoteNext = peerFrameAck = static_cast<std::uint32_t>(inputDelay);
+    localHashNext = remoteHashNext = peerHashAck = verifiedNext = 0;
+    for (auto& f : localFrames) f.tick = ~0u;
+    for (auto& f : remoteFrames) f.tick = ~0u;
+    for (auto& h : localHashes) h.tick = ~0u;
+    for (auto& h : remoteHashes) h.tick = ~0u;
+    pending.count = 0;
+    desyncTick = -1;
+}
+
+void Lockstep::reset() {
+    resetTicks();
+    connected = peerLost = false;
+    delayedCount = 0;
+    stats = {};
+}
+
+bool Lockstep::host(unsigned short port, unsigned matchSeed, int delayTicks) {
+    inputDelay = std::clamp(delayTicks, 1, MaxInputDelay);
+    reset();
+    player = 0;
+    seed = matchSeed;
+    socket.setBlocking(false);
+    // the client's address is learnt from its first packet
+    return socket.bind(port) == sf::Socket::Done;
+}
+
+bool Lockstep::join(const sf::IpAddress& hostAddress, unsigned short port) {
+    reset();
+    player = 1;
+    peerAddress = hostAddress;
+    peerPort = port;
+    socket.setBlocking(false);
+    return socket.bind(sf::Socket::AnyPort) == sf::Socket::Done;
+}
+
+void Lockstep::simulateLink(sf::Time lat, sf::Time jit, float lossRate) {
+    latency = lat;
+    jitter = jit;
+    loss = std::clamp(lossRate, 0.f, 1.f);
+}
+
+void Lockstep::transmit(const std::uint8_t* data, std::size_t size, sf::Time now) {
+    if (loss > 0.f && std::uniform_real_distribution<float>(0.f, 1.f)(linkRng) < loss) {
+        stats.packetsDropped++;
+        return;
+    }
+    if (latency == sf::Time::Zero && jitter == sf::Time::Zero) {
+        if (socket.send(data, size, peerAddress, peerPort) == sf::Socket::Done) {
+            stats.packetsSent++;
+            stats.bytesSent += size;
+        }
+        return;
+    }
+    if (delayedCount == MaxDelayed || size > sizeof(delayed[0].data)) {
+        stats.packetsDropped++; // the simulated link is congested
+        return;
+    }
+    Delayed& d = delayed[delayedCount++];
+    sf::Int64 spread = jitter.asMicroseconds();
+    d.due = now + latency + sf::microseconds(spread > 0 ? std::uniform_int_distribution<sf::Int64>(0, spread)(linkRng) : 0);
+    d.size = size;
+    std::memcpy(d.data, data, size);
+}
+
+void Lockstep::flushDelayed(sf::Time now) {
+    // jitter can reorder packets, as a real network would
+    int kept = 0;
+    for (int i = 0; i < delayedCount; ++i) {
+        Delayed& d = delayed[i];
+        if (d.due > now) {
+            if (kept != i) delayed[kept] = d;
+            ++kept;
+            continue;
+        }
+        if (socket.send(d.data, d.size, peerAddress, peerPort) == sf::Socket::Done) {
+            stats.packetsSent++;
+            stats.bytesSent += d.size;
+        }
+    }
+    delayedCount = kept;
+}
+
+void Lockstep::receive(sf::Time now) {
+    flushDelayed(now);
+    std::uint8_t buf[MaxPacket];
+    std::size_t size = 0;
+    sf::IpAddress from;
+    unsigned short fromPort = 0;
+    while (socket.receive(buf, sizeof(buf), size, from, fromPort) == sf::Socket::Done) {
+        if (player == 0 && !connected) {
+            // first client to say hello gets the seat
+            peerAddress = from;
+            peerPort = fromPort;
+        } else if (from != peerAddress || fromPort != peerPort) {
+            continue;
+        }
+        handlePacket(buf, size, now);
+    }
+    if (connected && now - lastHeard > PeerTimeout) peerLost = true;
+}
+
+void Lockstep::handlePacket(const std::uint8_t* data, std::size_t size, sf::Time now) {
+    Reader r{data, size};
+    if (r.u8() != Magic0 || r.u8() != Magic1 || r.u8() != Version) return;
+    std::uint8_t kind = r.u8();
+    std::uint8_t from = r.u8();
+    int peerDelay = r.u8();
+    std::uint32_t peerSeed = r.u32();
+    if (!r.ok || from == player || peerDelay < 1 || peerDelay > MaxInputDelay) return;
+    stats.packetsReceived++;
+    stats.bytesReceived += size;
+    lastHeard = now;
+    if (!connected) {
+        // the client plays the host's match, at the host's input delay
+        if (player == 1) {
+            seed = peerSeed;
+            inputDelay = peerDelay;
+            resetTicks();
+        }
+        connected = true;
+    }
+    if (kind != Data) return;
+
+    std::uint32_t frameAck = r.u32();
+    std::uint32_t hashAck = r.u32();
+    std::uint32_t firstFrame = r.u32();
+    int frameCount = r.u8();
+    if (!r.ok) return;
+    peerFrameAck = std::max(peerFrameAck, std::min(frameAck, localNext));
+    peerHashAck = std::max(peerHashAck, std::min(hashAck, localHashNext));
+    for (int i = 0; i < frameCount; ++i) {
+        std::uint32_t tick = firstFrame + static_cast<std::uint32_t>(i);
+        Frame f;
+        f.tick = tick;
+        f.count = r.u8();
+        if (f.count > MaxCommandsPerFrame) return;
+        for (int k = 0; k < f.count; ++k) {
+            f.cmds[k].kind = static_cast<CommandKind>(r.u8());
+            f.cmds[k].a = static_cast<std::int16_t>(r.u16());
+            f.cmds[k].b = static_cast<std::int16_t>(r.u16());
+            f.cmds[k].c = static_cast<std::int16_t>(r.u16());
+        }
+        if (!r.ok) return;
+        // repeats of frames we already have are the norm, not an error
+        if (tick >= remoteNext && tick - remoteNext < static_cast<std::uint32_t>(Window)) {
+            remoteFrames[tick % Window] = f;
+        }
+    }
+    while (remoteFrames[remoteNext % Window].tick == remoteNext) ++remoteNext;
+
+    std::uint32_t firstHash = r.u32();
+    int hashCount = r.u8();
+    for (int i = 0; i < hashCount; ++i) {
+        std::uint32_t tick = firstHash + static_cast<std::uint32_t>(i);
+        std::uint32_t value = r.u32();
+        if (!r.ok) return;
+        if (tick >= remoteHashNext && tick - verifiedNext < static_cast<std::uint32_t>(Window)) {
+            remoteHashes[tick % Window] = {tick, value};
+        }
+    }
+    while (remoteHashes[remoteHashNext % Window].tick == remoteHashNext) ++remoteHashNext;
+    compareHashes();
+}
+
+void Lockstep::send(sf::Time now) {
+    flushDelayed(now);
+    std::uint8_t buf[MaxPacket];
+    Writer w{buf, 0, sizeof(buf)};
+    w.u8(Magic0);
+    w.u8(Magic1);
+    w.u8(Version);
+    if (!connected) {
+        // only the client knows where to send before the handshake
+        if (player == 0 || now - lastSent < HelloInterval) return;
+        w.u8(Hello);
+        w.u8(static_cast<std::uint8_t>(player));
+        w.u8(static_cast<std::uint8_t>(inputDelay));
+        w.u32(seed);
+        lastSent = now;
+        transmit(buf, w.size, now);
+        return;
+    }
+    w.u8(Data);
+    w.u8(static_cast<std::uint8_t>(player));
+    w.u8(static_cast<std::uint8_t>(inputDelay));
+    w.u32(seed);
+    w.u32(remoteNext);
+    w.u32(remoteHashNext);
+    // every frame the peer has not acknowledged, oldest first, while they fit
+    w.u32(peerFrameAck);
+    std::size_t countAt = w.size;
+    w.u8(0);
+    const std::size_t frameRoom = MaxPacket - 5 - MaxHashesPerPacket * 4;
+    int frames = 0;
+    for (std::uint32_t t = peerFrameAck; t < localNext && frames < MaxFramesPerPacket; ++t) {
+        const Frame& f = localFrames[t % Window];
+        if (w.size + 1 + f.count * CommandSize > frameRoom) break;
+        w.u8(static_cast<std::uint8_t>(f.count));
+        for (int k = 0; k < f.count; ++k) {
+            w.u8(static_cast<std::uint8_t>(f.cmds[k].kind));
+            w.u16(static_cast<std::uint16_t>(f.cmds[k].a));
+            w.u16(static_cast<std::uint16_t>(f.cmds[k].b));
+            w.u16(static_cast<std::uint16_t>(f.cmds[k].c));
+        }
+        ++frames;
+    }
+    buf[countAt] = static_cast<std::uint8_t>(frames);
+    int hashes = static_cast<int>(std::min<std::uint32_t>(localHashNext - peerHashAck, MaxHashesPerPacket));
+    w.u32(peerHashAck);
+    w.u8(static_cast<std::uint8_t>(hashes));
+    for (int i = 0; i < hashes; ++i) w.u32(localHashes[(peerHashAck + i) % Window].value);
+    lastSent = now;
+    transmit(buf, w.size, now);
+}
+
+bool Lockstep::submit(const Command& c) {
+    if (pending.count == MaxCommandsPerFrame) return false;
+    pending.cmds[pending.count++] = c;
+    stats.commandsSent++;
+    return true;
+}
+
+int Lockstep::beginTick(std::uint32_t tick, Command* out, int max) {
+    // close the frame that will run inputDelay ticks from now
+    if (tick + inputDelay == localNext) {
+        Frame& f = localFrames[localNext % Window];
+        f = pending;
+        f.tick = localNext++;
+        pending.count = 0;
+    }
+    int n = 0;
+    if (tick < static_cast<std::uint32_t>(inputDelay)) return 0;
+    const Frame& mine = localFrames[tick % Window];
+    const Frame& theirs = remoteFrames[tick % Window];
+    const Frame* order[2] = {&mine, &theirs};
+    if (player == 1) std::swap(order[0], order[1]);
+    for (const Frame* f : order) {
+        if (f->tick != tick) continue;
+        for (int k = 0; k < f->count && n < max; ++k) out[n++] = f->cmds[k];
+    }
+    return n;
+}
+
+void Lockstep::endTick(std::uint32_t tick, std::uint64_t hash) {
+    // 32 bits on the wire are plenty to notice a divergence
+    localHashes[tick % Window] = {tick, static_cast<std::uint32_t>(hash ^ (hash >> 32))};
+    localHashNext = tick + 1;
+    compareHashes();
+}
+
+void Lockstep::compareHashes() {
+    while (verifiedNext < localHashNext && verifiedNext < remoteHashNext) {
+        const Hash& mine = localHashes[verifiedNext % Window];
+        const Hash& theirs = remoteHashes[verifiedNext % Window];
+        if (desyncTick < 0 && mine.tick == verifiedNext && theirs.tick == verifiedNext && mine.value != theirs.value) {
+            desyncTick = verifiedNext;
+        }
+        ++verifiedNext;
+    }
+}
@@ -1,11 +1,22 @@
 #include "Map.h"
+#include "AssetPack.h"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
-bool Map::loadFromFile(const std::string& filename) {
+bool Map::loadFromFile(const std::string& filename, bool withTextures) {
     std::ifstream file(filename);
     if (!file.is_open()) return false;
+    return loadFromStream(file, withTextures);
+}
+
+bool Map::loadFromString(const std::string& text, bool withTextures) {
+    std::istringstream in(text);
+    return loadFromStream(in, withTextures);
+}
+
+bool Map::loadFromStream(std::istream& file, bool withTextures) {
     tiles.clear();
     rows = 0;
     cols = 0;
@@ -17,12 +28,20 @@ bool Map::loadFromFile(const std::string& filename) {
         while (ss>>v) values.push_back(v);
         if (values.empty()) continue;
         if (rows == 0) cols = values.size();
+        if (static_cast<int>(values.size()) != cols) {
+            // ragged or cut short (half-written file): not a map
+            tiles.clear();
+            rows = 0;
+            cols = 0;
+            return false;
+        }
         for (int val : values) tiles.push_back(val);
         rows++;
     }
-    file.close();
+    rebuildIndex();
+    resetRenderCache();
     // attempt to load tile textures as well
-    loadTileTextures();
+    if (withTextures) loadTileTextures();
     return true;
 }
 
@@ -46,6 +65,8 @@ bool Map::saveToFile(const std::string& filename)  {
 Map::Map(int c, int r, float tsize) : cols(c), rows(r), tileSize(tsize) {
     tiles.assign(cols*rows, 0);
     for (int x=0;x<cols;x++) tiles[(rows/2)*cols + x] = 1;
+    rebuildIndex();
+    resetRenderCache();
 }
 
 Map::Map(float tsize) : cols(0), rows(0), tileSize(tsize) {
@@ -54,7 +75,37 @@ Map::Map(float tsize) : cols(0), rows(0), tileSize(tsize) {
 
 void Map::setTile(int tx, int ty, int value) {
     if (tx < 0 || ty < 0 || tx >= cols || ty >= rows) return;
-    tiles[ty*cols + tx] = value;
+    int& cur = tiles[ty*cols + tx];
+    if (cur == value) return;
+    // keep the special tile index in sync
+    if (cur == 3) unindex(baseTiles, tx, ty);
+    else if (cur == 4) unindex(spawnTiles, tx, ty);
+    if (value == 3) baseTiles.emplace_back(tx, ty);
+    else if (value == 4) spawnTiles.emplace_back(tx, ty);
+    cur = value;
+    markDirty(tx, ty);
+}
+
+void Map::rebuildIndex() {
+    spawnTiles.clear();
+    baseTiles.clear();
+    for (int y=0;y<rows;y++) {
+        for (int x=0;x<cols;x++) {
+            int v = tiles[y*cols + x];
+            if (v == 3) baseTiles.emplace_back(x, y);
+            else if (v == 4) spawnTiles.emplace_back(x, y);
+        }
+    }
+}
+
+void Map::unindex(std::vector<sf::Vector2i>& list, int tx, int ty) {
+    // special tiles are few: a linear search keeps the list order stable
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i].x == tx && list[i].y == ty) {
+            list.erase(list.begin() + i);
+            return;
+        }
+    }
 }
 
 int Map::getTile(int tx, int ty) const {
@@ -62,70 +113,167 @@ int Map::getTile(int tx, int ty) const {
     return tiles[ty*cols + tx];
 }
 
-void Map::draw(sf::RenderWindow& window) {
-    sf::RectangleShape rect({tileSize, tileSize});
-    sf::Sprite sprite;
-    for (int y=0;y<rows;y++) {
-        for (int x=0;x<cols;x++) {
+namespace {
+// plain tile colors, also used when a texture is missing and for the overview
+sf::Color tileColor(int v) {
+    switch (v) {
+        case 0: return sf::Color(50,180,50);   // herbe
+        case 1: return sf::Color(180,180,180); // chemin
+        case 2: return sf::Color(150,120,80);  // obstacles
+        case 3: return sf::Color(70,130,180);  // base finale (bleu)
+        case 4: return sf::Color(200,50,50);   // spawn (rouge)
+        default: return sf::Color::Magenta;
+    }
+}
+}
+
+void Map::resetRenderCache() {
+    chunkCols = (cols + ChunkSize - 1) / ChunkSize;
+    chunkRows = (rows + ChunkSize - 1) / ChunkSize;
+    chunks.clear();
+    chunks.resize(static_cast<size_t>(chunkCols) * chunkRows);
+    builtChunks = 0;
+    // the overview is recreated at the new size on its next draw
+    overviewReady = overviewFailed = false;
+}
+
+void Map::markDirty(int tx, int ty) {
+    if (!chunks.empty()) chunks[(ty / ChunkSize) * chunkCols + tx / ChunkSize].stale = true;
+    if (dirtyX1 < dirtyX0) {
+        dirtyX0 = dirtyX1 = tx;
+        dirtyY0 = dirtyY1 = ty;
+        return;
+    }
+    dirtyX0 = std::min(dirtyX0, tx);
+    dirtyY0 = std::min(dirtyY0, ty);
+    dirtyX1 = std::max(dirtyX1, tx);
+    dirtyY1 = std::max(dirtyY1, ty);
+}
+
+void Map::markAllDirty() {
+    for (auto& ch : chunks) ch.stale = true;
+    dirtyX0 = dirtyY0 = 0;
+    dirtyX1 = cols - 1;
+    dirtyY1 = rows - 1;
+}
+
+const sf::Texture* Map::layerTexture(int layer) const {
+    const sf::Texture* t = layer == Grass ? &grassTexture : layer == Paving ? &pavingTexture
+                         : layer == Stone ? &stoneTexture : nullptr;
+    return t && texturesLoaded && t->getSize().x > 0 ? t : nullptr;
+}
+
+void Map::buildChunk(int cx, int cy) {
+    Chunk& ch = chunks[cy * chunkCols + cx];
+    for (auto& l : ch.layers) l.clear();
+    int x1 = std::min(cols, (cx + 1) * ChunkSize), y1 = std::min(rows, (cy + 1) * ChunkSize);
+    for (int y = cy * ChunkSize; y < y1; y++) {
+        for (int x = cx * ChunkSize; x < x1; x++) {
             int v = tiles[y*cols + x];
-            rect.setPosition(x*tileSize, y*tileSize);
-            switch (v) {
-                case 0: // herbe (vert) -> grass2 texture
-                    if (texturesLoaded && grassTexture.getSize().x > 0) {
-                        sprite.setTexture(grassTexture);
-                        sprite.setScale(tileSize / grassTexture.getSize().x, tileSize / grassTexture.getSize().y);
-                        sprite.setOrigin(0,0);
-                        sprite.setPosition(x*tileSize, y*tileSize);
-                        window.draw(sprite);
-                    } else {
-                        rect.setFillColor(sf::Color(50,180,50));
-                        window.draw(rect);
-                    }
-                    break;
-                case 1: // chemin (gris) -> paving1 texture
-                    if (texturesLoaded && pavingTexture.getSize().x > 0) {
-                        sprite.setTexture(pavingTexture);
-                        sprite.setScale(tileSize / pavingTexture.getSize().x, tileSize / pavingTexture.getSize().y);
-                        sprite.setOrigin(0,0);
-                        sprite.setPosition(x*tileSize, y*tileSize);
-                        window.draw(sprite);
-                    } else {
-                        rect.setFillColor(sf::Color(180,180,180));
-                        window.draw(rect);
-                    }
-                    break;
-                case 2: // obstacles (marron) -> stone wall texture
-                    if (texturesLoaded && stoneTexture.getSize().x > 0) {
-                        sprite.setTexture(stoneTexture);
-                        sprite.setScale(tileSize / stoneTexture.getSize().x, tileSize / stoneTexture.getSize().y);
-                        sprite.setOrigin(0,0);
-                        sprite.setPosition(x*tileSize, y*tileSize);
-                        window.draw(sprite);
-                    } else {
-                        rect.setFillColor(sf::Color(150,120,80));
-                        window.draw(rect);
-                    }
-                    break;
-                case 3: // base finale (bleu)
-                    rect.setFillColor(sf::Color(70,130,180));
-                    window.draw(rect);
-                    break;
-                case 4: // spawn (rouge)
-                    rect.setFillColor(sf::Color(200,50,50));
-                    window.draw(rect);
-                    break;
-                default:
-                    rect.setFillColor(sf::Color::Magenta);
-                    window.draw(rect);
-                    break;
+            // grass, paving and walls are textured when their texture loaded
+            int layer = v >= 0 && v <= 2 && layerTexture(v) ? v : Plain;
+            const sf::Texture* tex = layerTexture(layer);
+            sf::Vector2f ts = tex ? sf::Vector2f(tex->getSize()) : sf::Vector2f();
+            sf::Color c = tex ? sf::Color::White : tileColor(v);
+            float px = x * tileSize, py = y * tileSize;
+            auto& out = ch.layers[layer];
+            out.emplace_back(sf::Vector2f(px, py), c, sf::Vector2f(0.f, 0.f));
+            out.emplace_back(sf::Vector2f(px + tileSize, py), c, sf::Vector2f(ts.x, 0.f));
+            out.emplace_back(sf::Vector2f(px + tileSize, py + tileSize), c, ts);
+            out.emplace_back(sf::Vector2f(px, py + tileSize), c, sf::Vector2f(0.f, ts.y));
+        }
+    }
+    if (!ch.built) builtChunks++;
+    ch.built = true;
+    ch.stale = false;
+}
+
+void Map::dropHiddenChunks() {
+    // only the chunks of this frame stay: panning back rebuilds the others
+    for (auto& ch : chunks) {
+        if (!ch.built || ch.lastDrawn == drawCount) continue;
+        for (auto& l : ch.layers) std::vector<sf::Vertex>().swap(l);
+        ch.built = false;
+        ch.stale = true;
+        builtChunks--;
+    }
+}
+
+bool Map::drawOverview(sf::RenderWindow& window) {
+    if (overviewFailed) return false;
+    if (!overviewReady) {
+        unsigned maxSize = sf::Texture::getMaximumSize();
+        if (static_cast<unsigned>(cols) > maxSize || static_cast<unsigned>(rows) > maxSize || !overview.create(cols, rows)) {
+            overviewFailed = true;
+            return false;
+        }
+        overviewSprite.setTextureRect(sf::IntRect(0, 0, cols, rows));
+        overviewSprite.setScale(tileSize, tileSize);
+        overviewReady = true;
+        markAllDirty();
+    }
+    if (dirtyX1 >= dirtyX0) {
+        int w = dirtyX1 - dirtyX0 + 1, h = dirtyY1 - dirtyY0 + 1;
+        overviewPixels.resize(static_cast<size_t>(w) * h * 4);
+        sf::Uint8* p = overviewPixels.data();
+        for (int y = dirtyY0; y <= dirtyY1; y++) {
+            for (int x = dirtyX0; x <= dirtyX1; x++, p += 4) {
+                sf::Color c = tileColor(tiles[y*cols + x]);
+                p[0] = c.r; p[1] = c.g; p[2] = c.b; p[3] = 255;
             }
         }
+        overview.update(overviewPixels.data(), w, h, dirtyX0, dirtyY0);
+        dirtyX1 = dirtyX0 - 1;
     }
+    // bound here rather than once: a copied Map must not point at the source's texture
+    overviewSprite.setTexture(overview);
+    window.draw(overviewSprite);
+    return true;
 }
 
-void Map::loadTileTextures() {
+void Map::draw(sf::RenderWindow& window) {
+    if (cols <= 0 || rows <= 0) return;
+    const sf::View& view = window.getView();
+    sf::Vector2f c = view.getCenter();
+    sf::Vector2f half = view.getSize() / 2.f;
+    // far out, a tile is a few pixels: one sprite for the whole map
+    float pixelsPerTile = tileSize * window.getSize().x / view.getSize().x;
+    if (pixelsPerTile < OverviewPixels && drawOverview(window)) return;
+    // only the chunks under the current view
+    int x0 = std::max(0, static_cast<int>((c.x - half.x) / tileSize) / ChunkSize);
+    int y0 = std::max(0, static_cast<int>((c.y - half.y) / tileSize) / ChunkSize);
+    int x1 = std::min(chunkCols - 1, static_cast<int>((c.x + half.x) / tileSize) / ChunkSize);
+    int y1 = std::min(chunkRows - 1, static_cast<int>((c.y + half.y) / tileSize) / ChunkSize);
+    drawCount++;
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            Chunk& ch = chunks[cy * chunkCols + cx];
+            if (ch.stale) buildChunk(cx, cy);
+            ch.lastDrawn = drawCount;
+            for (int l = 0; l < LayerCount; l++) {
+                const auto& v = ch.layers[l];
+                if (!v.empty()) window.draw(v.data(), v.size(), sf::Quads, sf::RenderStates(layerTexture(l)));
+            }
+        }
+    }
+    if (builtChunks > MaxCachedChunks) dropHiddenChunks();
+}
+
+void Map::loadTileTextures(bool fromFiles) {
     texturesLoaded = false;
     bool ok1 = false, ok2 = false, ok3 = false;
+    // pre-decoded pack first: no directory probing and no PNG decoding
+    if (!fromFiles) {
+        const AssetPack& pack = AssetPack::shared();
+        ok1 = pack.loadTexture(grassTexture, "tiles/grass2.png");
+        ok2 = pack.loadTexture(pavingTexture, "tiles/paving 1.png");
+        ok3 = pack.loadTexture(stoneTexture, "tiles/stone wall 10.png");
+        if (ok1 && ok2 && ok3) {
+            texturesLoaded = true;
+            for (auto& ch : chunks) ch.stale = true;
+            return;
+        }
+    }
     namespace fs = std::filesystem;
     if (fs::exists("assets/tiles/grass2.png")) ok1 = grassTexture.loadFromFile("assets/tiles/grass2.png");
     else if (fs::exists("../assets/tiles/grass2.png")) ok1 = grassTexture.loadFromFile("../assets/tiles/grass2.png");
@@ -134,17 +282,18 @@ void Map::loadTileTextures() {
     if (fs::exists("assets/tiles/stone wall 10.png")) ok3 = stoneTexture.loadFromFile("assets/tiles/stone wall 10.png");
     else if (fs::exists("../assets/tiles/stone wall 10.png")) ok3 = stoneTexture.loadFromFile("../assets/tiles/stone wall 10.png");
     if (ok1 || ok2 || ok3) texturesLoaded = true;
+    // chunks pick their layers and texture coordinates from the textures
+    for (auto& ch : chunks) ch.stale = true;
 }
 
 std::pair<int,int> Map::findBase() const {
-    for (int y=0;y<rows;y++) {
-        for (int x=0;x<cols;x++) {
-            if (tiles[y*cols + x] == 3) {
-                return {x,y};
-            }
-        }
-    }
-    return {-1,-1};
+    if (baseTiles.empty()) return {-1,-1};
+    return {baseTiles.front().x, baseTiles.front().y};
+}
+
+std::pair<int,int> Map::findSpawn() const {
+    if (spawnTiles.empty()) return {-1,-1};
+    return {spawnTiles.front().x, spawnTiles.front().y};
 }
 
 sf::Vector2f Map::tileCenter(int tx, int ty) const {
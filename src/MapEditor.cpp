@@ -0,0 +1,178 @@
+#include "MapEditor.h"
+#include "Game.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+void MapEditor::open() {
+    if (active) return;
+    active = true;
+    wasPaused = game.paused;
+    game.paused = true;
+    game.placingTower = false;
+    game.selectedTowerId = -1;
+    edited = false;
+    strokeValue = -1;
+    status.clear();
+    validate();
+}
+
+void MapEditor::close() {
+    if (!active) return;
+    flush();
+    active = false;
+    strokeValue = -1;
+    game.paused = wasPaused;
+    // skipped while painting: nothing can be placed in the editor
+    if (edited) game.rebuildPlacementValidity();
+}
+
+sf::Vector2i MapEditor::tileAt(const sf::Vector2f& world) const {
+    float ts = game.getMap().getTileSize();
+    return {static_cast<int>(std::floor(world.x / ts)), static_cast<int>(std::floor(world.y / ts))};
+}
+
+bool MapEditor::handleEvent(const sf::Event& ev) {
+    switch (ev.type) {
+        case sf::Event::KeyPressed: {
+            sf::Keyboard::Key k = ev.key.code;
+            if (k == sf::Keyboard::E || k == sf::Keyboard::Escape) {
+                close();
+                return true;
+            }
+            if (k >= sf::Keyboard::Num1 && k <= sf::Keyboard::Num5) {
+                brush = k - sf::Keyboard::Num1;
+                ++revision;
+                return true;
+            }
+            if (k == sf::Keyboard::LBracket || k == sf::Keyboard::RBracket) {
+                radius = std::clamp(radius + (k == sf::Keyboard::RBracket ? 1 : -1), 0, 8);
+                ++revision;
+                return true;
+            }
+            if (k == sf::Keyboard::S && ev.key.control) {
+                save();
+                return true;
+            }
+            // the match stays paused while editing
+            return k == sf::Keyboard::P || k == sf::Keyboard::Space;
+        }
+        case sf::Event::MouseButtonPressed: {
+            if (ev.mouseButton.button != sf::Mouse::Left && ev.mouseButton.button != sf::Mouse::Right) return false;
+            // right button erases back to grass
+            strokeValue = ev.mouseButton.button == sf::Mouse::Left ? brush : 0;
+            mouse = game.pixelToWorld(ev.mouseButton.x, ev.mouseButton.y);
+            lastTile = tileAt(mouse);
+            paintLine(lastTile, lastTile);
+            return true;
+        }
+        case sf::Event::MouseButtonReleased:
+            if (ev.mouseButton.button != sf::Mouse::Left && ev.mouseButton.button != sf::Mouse::Right) return false;
+            strokeValue = -1;
+            return true;
+        case sf::Event::MouseMoved: {
+            mouse = game.pixelToWorld(ev.mouseMove.x, ev.mouseMove.y);
+            if (strokeValue >= 0) {
+                // a fast drag skips tiles between two events: paint the segment
+                sf::Vector2i t = tileAt(mouse);
+                paintLine(lastTile, t);
+                lastTile = t;
+            }
+            return false; // camera drag and hover still need it
+        }
+        default:
+            return false;
+    }
+}
+
+void MapEditor::paintLine(sf::Vector2i from, sf::Vector2i to) {
+    // Bresenham, the brush stamped at every step
+    int dx = std::abs(to.x - from.x), dy = -std::abs(to.y - from.y);
+    int sx = from.x < to.x ? 1 : -1, sy = from.y < to.y ? 1 : -1;
+    int err = dx + dy;
+    int r = strokeValue >= 3 ? 0 : radius;
+    while (true) {
+        for (int y = -r; y <= r; ++y)
+            for (int x = -r; x <= r; ++x)
+                if (x * x + y * y <= r * r) paintAt(from.x + x, from.y + y);
+        if (from == to) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; from.x += sx; }
+        if (e2 <= dx) { err += dx; from.y += sy; }
+    }
+}
+
+void MapEditor::paintAt(int tx, int ty) {
+    Map& map = game.getMap();
+    if (tx < 0 || ty < 0 || tx >= map.getCols() || ty >= map.getRows()) return;
+    if (map.getTile(tx, ty) == strokeValue) return;
+    // towers stay where they are: no wall, base or spawn under them
+    if (strokeValue >= 2 && game.tileBlocked[ty][tx]) return;
+    map.setTile(tx, ty, strokeValue);
+    painted.emplace_back(tx, ty);
+}
+
+bool MapEditor::flush() {
+    if (painted.empty()) return false;
+    game.applyTileEdits(painted);
+    painted.clear();
+    edited = true;
+    status.clear();
+    validate();
+    return true;
+}
+
+void MapEditor::validate() {
+    // the field was just repaired: a spawn reaches a base iff it has a distance
+    cutSpawns.clear();
+    for (const auto& s : game.getMap().getSpawns()) {
+        if (game.getDistanceAt(s.x, s.y) < 0) cutSpawns.push_back(s);
+    }
+    ++revision;
+}
+
+bool MapEditor::isValid() const {
+    const Map& map = game.getMap();
+    return !map.getSpawns().empty() && !map.getBases().empty() && cutSpawns.empty();
+}
+
+void MapEditor::save() {
+    flush();
+    std::string path = game.assetsDir + "/Map.txt";
+    if (!isValid()) status = "Not saved: every spawn needs a way to a base";
+    else if (game.getMap().saveToFile(path)) status = "Saved " + path;
+    else status = "Cannot write " + path;
+    std::cout << status << std::endl;
+    ++revision;
+}
+
+void MapEditor::draw(sf::RenderTarget& target) {
+    if (!active) return;
+    const float ts = game.getMap().getTileSize();
+    marker.setSize({ts - 4.f, ts - 4.f});
+    marker.setFillColor(sf::Color::Transparent);
+    marker.setOutlineThickness(3.f);
+    marker.setOutlineColor(sf::Color(255, 40, 40));
+    for (const auto& s : cutSpawns) {
+        marker.setPosition(s.x * ts + 2.f, s.y * ts + 2.f);
+        target.draw(marker);
+    }
+    sf::Vector2i t = tileAt(mouse);
+    int r = getRadius();
+    if (r == 0) {
+        marker.setOutlineThickness(2.f);
+        marker.setOutlineColor(sf::Color::White);
+        marker.setPosition(t.x * ts + 2.f, t.y * ts + 2.f);
+        target.draw(marker);
+        return;
+    }
+    float br = (r + 0.5f) * ts;
+    brushShape.setRadius(br);
+    brushShape.setOrigin(br, br);
+    brushShape.setPosition((t.x + 0.5f) * ts, (t.y + 0.5f) * ts);
+    brushShape.setFillColor(sf::Color::Transparent);
+    brushShape.setOutlineThickness(2.f);
+    brushShape.setOutlineColor(sf::Color::White);
+    target.draw(brushShape);
+}
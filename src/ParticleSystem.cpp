@@ -0,0 +1,207 @@
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cmath>
+
+void ParticleSystem::init(int n) {
+    capacity = std::max(n, 0);
+    budget = capacity;
+    count = 0;
+    dropped = 0;
+    for (auto* v : {&px, &py, &vx, &vy, &ay, &drag, &life, &invLife, &size}) v->assign(capacity, 0.f);
+    color.assign(capacity, 0);
+    vertices.assign(static_cast<size_t>(capacity) * 4, sf::Vertex());
+}
+
+void ParticleSystem::setBudget(int n) {
+    budget = std::clamp(n, 0, capacity);
+    // the oldest particles are at the front: keep the newest
+    if (count > budget) {
+        int cut = count - budget;
+        for (auto* v : {&px, &py, &vx, &vy, &ay, &drag, &life, &invLife, &size}) {
+            std::copy(v->begin() + cut, v->begin() + count, v->begin());
+        }
+        std::copy(color.begin() + cut, color.begin() + count, color.begin());
+        count = budget;
+    }
+}
+
+float ParticleSystem::random01() {
+    // xorshift32: cheap, and independent from the game's rng
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed >> 8) * (1.f / 16777216.f);
+}
+
+void ParticleSystem::emit(const sf::Vector2f& at, const Burst& b) {
+    int n = std::min(b.count, budget - count);
+    if (n < b.count) dropped += static_cast<std::uint64_t>(b.count - std::max(n, 0));
+    for (int k = 0; k < n; ++k) {
+        int i = count++;
+        float a = random01() * 6.2831853f;
+        float s = b.speedMin + (b.speedMax - b.speedMin) * random01();
+        float off = b.spread * random01();
+        float ca = std::cos(a), sa = std::sin(a);
+        px[i] = at.x + ca * off;
+        py[i] = at.y + sa * off;
+        vx[i] = ca * s;
+        vy[i] = sa * s;
+        ay[i] = b.accelY;
+        drag[i] = b.drag;
+        life[i] = b.lifeMin + (b.lifeMax - b.lifeMin) * random01();
+        invLife[i] = 1.f / life[i];
+        size[i] = b.sizeMin + (b.sizeMax - b.sizeMin) * random01();
+        float t = random01();
+        auto mix = [t](sf::Uint8 x, sf::Uint8 y) { return static_cast<std::uint32_t>(x + (y - x) * t); };
+        color[i] = mix(b.colorA.r, b.colorB.r) << 24 | mix(b.colorA.g, b.colorB.g) << 16 |
+                   mix(b.colorA.b, b.colorB.b) << 8 | mix(b.colorA.a, b.colorB.a);
+    }
+}
+
+namespace {
+// no branches and no aliasing between the arrays: vectorizes
+void integrate(int n, float dt, float* __restrict x, float* __restrict y, float* __restrict u,
+               float* __restrict v, float* __restrict life, const float* __restrict ay, const float* __restrict drag) {
+    for (int i = 0; i < n; ++i) {
+        float damp = std::max(0.f, 1.f - drag[i] * dt);
+        u[i] *= damp;
+        v[i] = v[i] * damp + ay[i] * dt;
+        x[i] += u[i] * dt;
+        y[i] += v[i] * dt;
+        life[i] -= dt;
+    }
+}
+}
+
+void ParticleSystem::update(float dt) {
+    if (count == 0) return;
+    integrate(count, dt, px.data(), py.data(), vx.data(), vy.data(), life.data(), ay.data(), drag.data());
+    // compact the dead out, keeping the order (oldest first)
+    int w = 0;
+    for (int i = 0; i < count; ++i) {
+        if (life[i] <= 0.f) continue;
+        if (w != i) {
+            px[w] = px[i]; py[w] = py[i]; vx[w] = vx[i]; vy[w] = vy[i]; life[w] = life[i];
+            ay[w] = ay[i]; drag[w] = drag[i]; invLife[w] = invLife[i];
+            size[w] = size[i]; color[w] = color[i];
+        }
+        ++w;
+    }
+    count = w;
+}
+
+void ParticleSystem::draw(sf::RenderTarget& target, const sf::FloatRect& visible) {
+    if (count == 0) return;
+    const float x0 = visible.left, y0 = visible.top;
+    const float x1 = visible.left + visible.width, y1 = visible.top + visible.height;
+    size_t v = 0;
+    for (int i = 0; i < count; ++i) {
+        float f = life[i] * invLife[i]; // 1 at birth, 0 at death
+        float s = size[i] * (0.4f + 0.6f * f);
+        float x = px[i], y = py[i];
+        if (x + s < x0 || x - s > x1 || y + s < y0 || y - s > y1) continue;
+        std::uint32_t c = color[i];
+        sf::Color col(static_cast<sf::Uint8>(c >> 24), static_cast<sf::Uint8>(c >> 16), static_cast<sf::Uint8>(c >> 8),
+                      static_cast<sf::Uint8>((c & 0xff) * f));
+        sf::Vertex* q = &vertices[v];
+        q[0].position = {x - s, y - s};
+        q[1].position = {x + s, y - s};
+        q[2].position = {x + s, y + s};
+        q[3].position = {x - s, y + s};
+        q[0].color = q[1].color = q[2].color = q[3].color = col;
+        v += 4;
+    }
+    if (v) target.draw(vertices.data(), v, sf::Quads, sf::RenderStates(sf::BlendAdd));
+}
+
+void ParticleSystem::explosion(const sf::Vector2f& at, float radius) {
+    Burst fire;
+    fire.count = 48;
+    fire.speedMin = radius * 0.5f;
+    fire.speedMax = radius * 3.f;
+    fire.lifeMin = 0.25f;
+    fire.lifeMax = 0.6f;
+    fire.sizeMin = 3.f;
+    fire.sizeMax = 7.f;
+    fire.drag = 5.f;
+    fire.colorA = sf::Color(255, 220, 90, 255);
+    fire.colorB = sf::Color(255, 80, 10, 220);
+    emit(at, fire);
+    Burst smoke;
+    smoke.count = 16;
+    smoke.speedMin = 5.f;
+    smoke.speedMax = 30.f;
+    smoke.lifeMin = 0.6f;
+    smoke.lifeMax = 1.2f;
+    smoke.sizeMin = 5.f;
+    smoke.sizeMax = 9.f;
+    smoke.spread = radius * 0.3f;
+    smoke.drag = 1.f;
+    smoke.accelY = -25.f;
+    smoke.colorA = sf::Color(90, 80, 70, 120);
+    smoke.colorB = sf::Color(50, 50, 50, 90);
+    emit(at, smoke);
+}
+
+void ParticleSystem::fireTrail(const sf::Vector2f& at) {
+    Burst b;
+    b.count = 2;
+    b.speedMin = 5.f;
+    b.speedMax = 25.f;
+    b.lifeMin = 0.15f;
+    b.lifeMax = 0.3f;
+    b.sizeMin = 1.5f;
+    b.sizeMax = 3.f;
+    b.spread = 2.f;
+    b.accelY = -60.f;
+    b.colorA = sf::Color(255, 200, 60, 230);
+    b.colorB = sf::Color(255, 90, 0, 200);
+    emit(at, b);
+}
+
+void ParticleSystem::fireHit(const sf::Vector2f& at) {
+    Burst b;
+    b.count = 14;
+    b.speedMin = 40.f;
+    b.speedMax = 140.f;
+    b.lifeMin = 0.2f;
+    b.lifeMax = 0.45f;
+    b.sizeMin = 1.5f;
+    b.sizeMax = 3.f;
+    b.drag = 4.f;
+    b.accelY = 120.f;
+    b.colorA = sf::Color(255, 240, 150, 255);
+    b.colorB = sf::Color(255, 120, 20, 230);
+    emit(at, b);
+}
+
+void ParticleSystem::kill(const sf::Vector2f& at, const sf::Color& c) {
+    Burst b;
+    b.count = 24;
+    b.speedMin = 30.f;
+    b.speedMax = 110.f;
+    b.lifeMin = 0.3f;
+    b.lifeMax = 0.7f;
+    b.sizeMin = 2.f;
+    b.sizeMax = 4.f;
+    b.drag = 3.f;
+    b.colorA = c;
+    b.colorB = sf::Color(255, 255, 255, 200);
+    emit(at, b);
+}
+
+void ParticleSystem::leak(const sf::Vector2f& at) {
+    Burst b;
+    b.count = 40;
+    b.speedMin = 60.f;
+    b.speedMax = 160.f;
+    b.lifeMin = 0.4f;
+    b.lifeMax = 0.9f;
+    b.sizeMin = 2.f;
+    b.sizeMax = 5.f;
+    b.spread = 6.f;
+    b.drag = 2.5f;
+    b.colorA = sf::Color(80, 160, 255, 255);
+    b.colorB = sf::Color(220, 40, 40, 230);
+    emit(at, b);
+}
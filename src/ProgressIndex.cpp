@@ -0,0 +1,68 @@
+#include "ProgressIndex.h"
+#include "Enemy.h"
+#include <algorithm>
+#include <cstring>
+
+void ProgressIndex::add(Enemy* e) {
+    entries.push_back({Unranked, e, e->getSerial()});
+}
+
+void ProgressIndex::refresh() {
+    // drop the dead (a recycled enemy has a new serial and was added again)
+    // and rekey the rest in the same pass
+    size_t w = 0, descents = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry en = entries[i];
+        if (!en.enemy->isAlive() || en.enemy->getSerial() != en.serial) continue;
+        en.key = en.enemy->getProgress();
+        if (w > 0 && en.key < entries[w - 1].key) ++descents;
+        entries[w++] = en;
+    }
+    entries.resize(w);
+    if (descents > 16 && descents * 8 > w) {
+        // many moved at once (the field changed under everyone): insertion
+        // sort would go quadratic
+        radixSort();
+        return;
+    }
+    // nearly sorted already: insertion sort moves only the few that overtook
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (!(entries[i].key < entries[i - 1].key)) continue;
+        Entry en = entries[i];
+        size_t j = i;
+        do {
+            entries[j] = entries[j - 1];
+            --j;
+        } while (j > 0 && en.key < entries[j - 1].key);
+        entries[j] = en;
+    }
+}
+
+void ProgressIndex::radixSort() {
+    // LSD on the key bits, 8 at a time; stable like the insertion sort, so
+    // both give the same order (ties keep their previous order)
+    auto bits = [](float k) {
+        std::uint32_t u;
+        std::memcpy(&u, &k, sizeof u);
+        // order-preserving for negative floats too
+        return u & 0x80000000u ? ~u : u | 0x80000000u;
+    };
+    scratch.resize(entries.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        std::size_t count[257] = {};
+        for (const Entry& e : entries) count[((bits(e.key) >> shift) & 0xff) + 1]++;
+        for (int b = 1; b < 257; ++b) count[b] += count[b - 1];
+        for (const Entry& e : entries) scratch[count[(bits(e.key) >> shift) & 0xff]++] = e;
+        entries.swap(scratch);
+    }
+}
+
+std::size_t ProgressIndex::lowerBound(float k) const {
+    return std::lower_bound(entries.begin(), entries.end(), k,
+                            [](const Entry& e, float v) { return e.key < v; }) - entries.begin();
+}
+
+std::size_t ProgressIndex::upperBound(float k) const {
+    return std::upper_bound(entries.begin(), entries.end(), k,
+                            [](float v, const Entry& e) { return v < e.key; }) - entries.begin();
+}
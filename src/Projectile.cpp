@@ -7,7 +7,17 @@ Projectile::Projectile(sf::Vector2f p, sf::Vector2f d, float s, float dmg, Game*
     : pos(p), dir(d), speed(s), damage(dmg), game(g), projType(type) {}
 
 void Projectile::update(float dt) {
+    sf::Vector2f start = pos;
     pos += dir * speed * dt;
+    traveled += speed * dt;
+    if (projType == 1 && game) game->particles.fireTrail(pos);
+
+    if (visualOnly) {
+        // damage is applied by Game::resolveScheduledHit, just fly to the intercept
+        lifeTime -= dt;
+        if (lifeTime <= 0.f) dead = true;
+        return;
+    }
 
     if (!game) return; // no collision if game ptr not set
 
@@ -15,33 +25,32 @@ void Projectile::update(float dt) {
     float projectileRadius = 5.f;
     if (projType == 1) {
         // larger radius for the cannon projectile (fire)
-        if (game) {
-            float ts = game->getMap().getTileSize();
-            projectileRadius = std::max(12.f, ts * 0.25f); // ~25% of tile size, min 12px
-        } else {
-            projectileRadius = 14.f;
-        }
+        float ts = game->getMap().getTileSize();
+        projectileRadius = std::max(12.f, ts * 0.25f); // ~25% of tile size, min 12px
     } else if (projType == 2) {
         projectileRadius = 8.f; // big sniper ball
     }
-    
-    for (auto& e : game->enemies) {
-        if (!e->isAlive()) continue;
 
-        sf::Vector2f delta = e->getPosition() - pos;
-        float dist = std::sqrt(delta.x * delta.x + delta.y * delta.y);
-        float collisionDist = e->getRadius() + projectileRadius;
-        
-        if (dist <= collisionDist) {
-            e->takeDamage(damage);
-            dead = true;
-            return;
-        }
+    // swept test over the whole step so fast shots cannot tunnel through an enemy,
+    // only enemies in the grid cells along the segment are considered
+    float tHit = 0.f;
+    int hit = game->enemyGrid.sweepFirst(start, pos, projectileRadius, tHit);
+    if (hit >= 0) {
+        game->applyProjectileHit(*game->enemies[hit], damage, towerId, projType);
+        pos = start + (pos - start) * tHit;
+        dead = true;
+        return;
     }
 
-    // check if projectile went off-screen (simple bounds check)
-    if (pos.x < -100 || pos.x > 3000 || pos.y < -100 || pos.y > 3000) {
+    // cull once out of range or outside the map
+    const Map& m = game->getMap();
+    float margin = m.getTileSize();
+    float w = m.getCols() * m.getTileSize();
+    float h = m.getRows() * m.getTileSize();
+    if ((maxTravel > 0.f && traveled > maxTravel) ||
+        pos.x < -margin || pos.x > w + margin || pos.y < -margin || pos.y > h + margin) {
         dead = true;
+        game->reportDeath(Game::DeathCause::Expired, towerId, 0, pos);
     }
 }
 
@@ -0,0 +1,57 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+
+namespace {
+const float SettleTime = 0.5f;   // after a change, before judging again
+const float QuickUndo = 2.f;     // a step up undone sooner than this backs off
+const float HeadroomShare = 0.6f; // "well under budget"
+const float MaxUpWait = 30.f;
+}
+
+void QualityGovernor::reset() {
+    sampleCount = sampleHead = 0;
+    sum = average = 0.f;
+    sinceChange = underFor = 0.f;
+}
+
+void QualityGovernor::setEnabled(bool on) {
+    enabled = on;
+    level = 0;
+    upWait = 3.f;
+    steppedUp = false;
+    reset();
+}
+
+bool QualityGovernor::frame(float work) {
+    if (!enabled) return false;
+    // rolling average over the last Window frames
+    if (sampleCount == Window) sum -= samples[sampleHead];
+    else ++sampleCount;
+    samples[sampleHead] = work;
+    sum += work;
+    sampleHead = (sampleHead + 1) % Window;
+    average = sum / sampleCount;
+
+    float elapsed = std::max(work, budget); // a paced frame lasts at least the budget
+    sinceChange += elapsed;
+    if (sinceChange < SettleTime || sampleCount < Window) return false;
+
+    if (average > budget && level < MaxLevel) {
+        // a step up that could not hold: wait longer before the next one
+        if (steppedUp && sinceChange < QuickUndo) upWait = std::min(upWait * 2.f, MaxUpWait);
+        ++level;
+        steppedUp = false;
+        sinceChange = underFor = 0.f;
+        reset();
+        return true;
+    }
+    underFor = average < budget * HeadroomShare ? underFor + elapsed : 0.f;
+    if (underFor >= upWait && level > 0) {
+        --level;
+        steppedUp = true;
+        sinceChange = underFor = 0.f;
+        reset();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,203 @@
+#include "SpatialGrid.h"
+#include "Enemy.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void SpatialGrid::init(int c, int r, float cs) {
+    cols = std::max(c, 1);
+    rows = std::max(r, 1);
+    cellSize = cs;
+    cellCount.assign(cols * rows, 0);
+    cellStop.assign(cols * rows, 0);
+    occupied.clear();
+    cellStamp.assign(cols * rows, 0);
+    stamp = 0;
+    cellItems.clear();
+}
+
+int SpatialGrid::cellX(float x) const {
+    return std::clamp(static_cast<int>(std::floor(x / cellSize)), 0, cols - 1);
+}
+
+int SpatialGrid::cellY(float y) const {
+    return std::clamp(static_cast<int>(std::floor(y / cellSize)), 0, rows - 1);
+}
+
+void SpatialGrid::reserve(size_t n) {
+    for (auto* v : {&itemX, &itemY, &itemR, &sortX, &sortY, &sortR}) v->reserve(n);
+    for (auto* v : {&itemCell, &cellItems, &itemSlot, &occupied}) v->reserve(n);
+}
+
+void SpatialGrid::rebuild(const std::vector<std::shared_ptr<Enemy>>& enemies) {
+    size_t n = enemies.size();
+    source = &enemies;
+    itemX.resize(n);
+    itemY.resize(n);
+    itemR.resize(n);
+    itemCell.resize(n);
+    cellItems.resize(n);
+    sortX.resize(n);
+    sortY.resize(n);
+    sortR.resize(n);
+    itemSlot.resize(n);
+    // only last tick's cells hold counts
+    for (int c : occupied) cellCount[c] = 0;
+    occupied.clear();
+    maxRadius = 0.f;
+
+    // counting sort by cell, over the occupied cells only: count, prefix sum, scatter
+    for (size_t i = 0; i < n; ++i) {
+        const Enemy& e = *enemies[i];
+        sf::Vector2f p = e.getPosition();
+        itemX[i] = p.x;
+        itemY[i] = p.y;
+        itemR[i] = e.isAlive() ? e.getRadius() : -1.f;
+        maxRadius = std::max(maxRadius, itemR[i]);
+        int cell = cellY(p.y) * cols + cellX(p.x);
+        itemCell[i] = cell;
+        if (cellCount[cell]++ == 0) occupied.push_back(cell);
+    }
+    // cellItems stays in cell order, so 3 neighbor cells of a row remain one span
+    std::sort(occupied.begin(), occupied.end());
+    // cellStop starts as the scatter cursor of each cell and ends up at its end
+    int start = 0;
+    for (int c : occupied) {
+        cellStop[c] = start;
+        start += cellCount[c];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int slot = cellStop[itemCell[i]]++;
+        cellItems[slot] = static_cast<int>(i);
+        itemSlot[i] = slot;
+        sortX[slot] = itemX[i];
+        sortY[slot] = itemY[i];
+        // dead items get a hugely negative radius so they never overlap anything
+        sortR[slot] = itemR[i] < 0.f ? -1e9f : itemR[i];
+    }
+}
+
+void SpatialGrid::setPosition(int item, float x, float y) {
+    itemX[item] = x;
+    itemY[item] = y;
+    sortX[itemSlot[item]] = x;
+    sortY[itemSlot[item]] = y;
+}
+
+void SpatialGrid::separation(float spacing, std::vector<float>& pushX, std::vector<float>& pushY) const {
+    size_t n = cellItems.size();
+    pushX.assign(n, 0.f);
+    pushY.assign(n, 0.f);
+    const float* xs = sortX.data();
+    const float* ys = sortY.data();
+    const float* rs = sortR.data();
+    // slots of cells x0..x1 of row y, one span since cellItems is in cell order (empty if none is occupied)
+    auto rowSpan = [&](int y, int x0, int x1, int& b, int& e) {
+        b = e = 0;
+        for (int x = x0; x <= x1; ++x) {
+            int c = y * cols + x;
+            if (cellCount[c] == 0) continue;
+            if (b == e) b = cellStop[c] - cellCount[c];
+            e = cellStop[c];
+        }
+    };
+    for (int cell : occupied) {
+        int cx = cell % cols, cy = cell / cols;
+        int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, cols - 1);
+        int y0 = std::max(cy - 1, 0), y1 = std::min(cy + 1, rows - 1);
+        int spanB[3], spanE[3];
+        for (int ny = y0; ny <= y1; ++ny) rowSpan(ny, x0, x1, spanB[ny - y0], spanE[ny - y0]);
+        for (int k = cellStop[cell] - cellCount[cell]; k < cellStop[cell]; ++k) {
+            if (rs[k] < 0.f) continue;
+            const float xi = xs[k], yi = ys[k], ri = rs[k];
+            float fx = 0.f, fy = 0.f;
+            for (int r = 0; r <= y1 - y0; ++r) {
+                for (int j = spanB[r]; j < spanE[r]; ++j) {
+                    float dx = xi - xs[j], dy = yi - ys[j];
+                    float d2 = dx * dx + dy * dy;
+                    float minD = (ri + rs[j]) * spacing;
+                    float d = std::sqrt(d2 + 1e-6f);
+                    float overlap = std::max(0.f, minD - d);
+                    // stacked exactly on top of each other: split along x by
+                    // slot order (self has k == j and contributes nothing)
+                    float tie = d2 < 1e-4f ? static_cast<float>((k > j) - (k < j)) : 0.f;
+                    fx += (dx / d + tie) * overlap * 0.5f;
+                    fy += dy / d * overlap * 0.5f;
+                }
+            }
+            pushX[cellItems[k]] = fx;
+            pushY[cellItems[k]] = fy;
+        }
+    }
+}
+
+int SpatialGrid::sweepFirst(const sf::Vector2f& a, const sf::Vector2f& b, float radius, float& tHit) {
+    if (cellItems.empty()) return -1;
+    if (++stamp == 0) { // wrapped: reset stamps
+        std::fill(cellStamp.begin(), cellStamp.end(), 0);
+        stamp = 1;
+    }
+
+    const float reachPx = radius + maxRadius;
+    const int reach = std::max(1, static_cast<int>(std::ceil(reachPx / cellSize)));
+    const sf::Vector2f d = b - a;
+    const float dd = d.x * d.x + d.y * d.y;
+    int best = -1;
+    float bestT = std::numeric_limits<float>::max();
+
+    auto testCell = [&](int cx, int cy) {
+        if (cx < 0 || cy < 0 || cx >= cols || cy >= rows) return;
+        int cell = cy * cols + cx;
+        if (cellStamp[cell] == stamp) return;
+        cellStamp[cell] = stamp;
+        for (int k = cellStop[cell] - cellCount[cell]; k < cellStop[cell]; ++k) {
+            int i = cellItems[k];
+            if (itemR[i] < 0.f) continue;
+            // segment vs circle of radius (enemy + projectile)
+            float R = itemR[i] + radius;
+            float fx = a.x - itemX[i], fy = a.y - itemY[i];
+            float c = fx * fx + fy * fy - R * R;
+            float t;
+            if (c <= 0.f) {
+                t = 0.f; // already overlapping at the start of the step
+            } else {
+                if (dd <= 0.f) continue;
+                float bq = fx * d.x + fy * d.y;
+                float disc = bq * bq - dd * c;
+                if (bq >= 0.f || disc < 0.f) continue; // moving away or missing
+                t = (-bq - std::sqrt(disc)) / dd;
+                if (t > 1.f) continue;
+            }
+            // itemR only knows who was alive at rebuild(): a shot earlier in
+            // this tick may have killed it since
+            if (t < bestT && (*source)[i]->isAlive()) { bestT = t; best = i; }
+        }
+    };
+    auto visit = [&](int cx, int cy) {
+        for (int oy = -reach; oy <= reach; ++oy)
+            for (int ox = -reach; ox <= reach; ++ox) testCell(cx + ox, cy + oy);
+    };
+
+    // Amanatides-Woo traversal of the cells under the segment
+    int cx = static_cast<int>(std::floor(a.x / cellSize));
+    int cy = static_cast<int>(std::floor(a.y / cellSize));
+    int ex = static_cast<int>(std::floor(b.x / cellSize));
+    int ey = static_cast<int>(std::floor(b.y / cellSize));
+    const float inf = std::numeric_limits<float>::max();
+    int stepX = d.x > 0.f ? 1 : -1;
+    int stepY = d.y > 0.f ? 1 : -1;
+    float tMaxX = d.x != 0.f ? ((cx + (d.x > 0.f ? 1 : 0)) * cellSize - a.x) / d.x : inf;
+    float tMaxY = d.y != 0.f ? ((cy + (d.y > 0.f ? 1 : 0)) * cellSize - a.y) / d.y : inf;
+    float tDeltaX = d.x != 0.f ? cellSize / std::abs(d.x) : inf;
+    float tDeltaY = d.y != 0.f ? cellSize / std::abs(d.y) : inf;
+    int steps = std::abs(ex - cx) + std::abs(ey - cy);
+    visit(cx, cy);
+    for (int s = 0; s < steps; ++s) {
+        if (tMaxX < tMaxY) { cx += stepX; tMaxX += tDeltaX; }
+        else { cy += stepY; tMaxY += tDeltaY; }
+        visit(cx, cy);
+    }
+
+    if (best >= 0) tHit = bestT;
+    return best;
+}
@@ -0,0 +1,143 @@
+#include "TimerWheel.h"
+#include <cmath>
+
+TimerWheel::TimerWheel(float tick) : tickSeconds(tick) {
+    heads.assign(Levels * SlotsPerLevel + 1, NoNode);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(float delay, std::function<void()> callback) {
+    float ticks = std::ceil(delay / tickSeconds - 1e-4f);
+    return scheduleTicks(ticks > 1.f ? static_cast<std::uint64_t>(ticks) : 1, std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::scheduleTicks(std::uint64_t ticks, std::function<void()> callback) {
+    std::uint32_t idx;
+    if (!freeNodes.empty()) {
+        idx = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        idx = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& n = nodes[idx];
+    n.expire = currentTick + (ticks > 0 ? ticks : 1);
+    n.callback = std::move(callback);
+    insert(idx);
+    ++pending;
+    return (static_cast<TimerId>(n.generation) << 32) | idx;
+}
+
+void TimerWheel::cancel(TimerId id) {
+    if (!isPending(id)) return;
+    std::uint32_t idx = static_cast<std::uint32_t>(id & 0xFFFFFFFFu);
+    unlink(idx);
+    release(idx);
+}
+
+bool TimerWheel::isPending(TimerId id) const {
+    if (id == InvalidTimer) return false;
+    std::uint32_t idx = static_cast<std::uint32_t>(id & 0xFFFFFFFFu);
+    std::uint32_t gen = static_cast<std::uint32_t>(id >> 32);
+    return idx < nodes.size() && nodes[idx].generation == gen && nodes[idx].list != -1;
+}
+
+void TimerWheel::clear() {
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].list != -1) release(i);
+    }
+    heads.assign(heads.size(), NoNode);
+    currentTick = 0;
+    accumulator = 0.f;
+}
+
+void TimerWheel::reserve(size_t n) {
+    nodes.reserve(n);
+    freeNodes.reserve(n);
+    firing.reserve(n);
+}
+
+void TimerWheel::advance(float dt) {
+    accumulator += dt;
+    while (accumulator >= tickSeconds) {
+        accumulator -= tickSeconds;
+        tick();
+    }
+}
+
+void TimerWheel::tick() {
+    ++currentTick;
+    // the overflow list is only revisited when the whole wheel wraps
+    if ((currentTick & ((std::uint64_t(1) << (LevelBits * Levels)) - 1)) == 0) cascade(overflowList());
+    // cascade from the highest level whose slot boundary we just crossed
+    for (int level = Levels - 1; level >= 1; --level) {
+        std::uint64_t mask = (std::uint64_t(1) << (LevelBits * level)) - 1;
+        if ((currentTick & mask) != 0) continue;
+        int slot = static_cast<int>((currentTick >> (LevelBits * level)) & (SlotsPerLevel - 1));
+        cascade(level * SlotsPerLevel + slot);
+    }
+
+    // detach the due slot first: callbacks may schedule new timers
+    int list = static_cast<int>(currentTick & (SlotsPerLevel - 1));
+    firing.clear();
+    for (std::uint32_t idx = heads[list]; idx != NoNode; idx = nodes[idx].next) firing.push_back(idx);
+    heads[list] = NoNode;
+    for (std::uint32_t idx : firing) nodes[idx].list = -2; // detached but still pending
+
+    for (size_t i = 0; i < firing.size(); ++i) {
+        std::uint32_t idx = firing[i];
+        Node& n = nodes[idx];
+        if (n.list != -2) continue; // cancelled by an earlier callback of this tick
+        std::function<void()> cb = std::move(n.callback);
+        release(idx);
+        cb();
+    }
+}
+
+void TimerWheel::insert(std::uint32_t idx) {
+    Node& n = nodes[idx];
+    int list = overflowList();
+    // pick the lowest level where the timer shares the current block
+    for (int level = 0; level < Levels; ++level) {
+        int shift = LevelBits * (level + 1);
+        if ((n.expire >> shift) == (currentTick >> shift)) {
+            int slot = static_cast<int>((n.expire >> (LevelBits * level)) & (SlotsPerLevel - 1));
+            list = level * SlotsPerLevel + slot;
+            break;
+        }
+    }
+    n.list = list;
+    n.prev = NoNode;
+    n.next = heads[list];
+    if (n.next != NoNode) nodes[n.next].prev = idx;
+    heads[list] = idx;
+}
+
+void TimerWheel::unlink(std::uint32_t idx) {
+    Node& n = nodes[idx];
+    if (n.list < 0) return; // detached in tick()
+    if (n.prev != NoNode) nodes[n.prev].next = n.next;
+    else heads[n.list] = n.next;
+    if (n.next != NoNode) nodes[n.next].prev = n.prev;
+    n.next = n.prev = NoNode;
+}
+
+void TimerWheel::cascade(int list) {
+    std::uint32_t idx = heads[list];
+    heads[list] = NoNode;
+    while (idx != NoNode) {
+        std::uint32_t next = nodes[idx].next;
+        insert(idx);
+        idx = next;
+    }
+}
+
+void TimerWheel::release(std::uint32_t idx) {
+    Node& n = nodes[idx];
+    n.list = -1;
+    n.next = n.prev = NoNode;
+    n.callback = nullptr;
+    ++n.generation;
+    if (n.generation == 0) n.generation = 1; // keep ids non-zero
+    freeNodes.push_back(idx);
+    --pending;
+}
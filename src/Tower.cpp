@@ -25,44 +25,138 @@ Tower::Tower(const sf::Vector2f& position, int c, Game* game)
     baseShape.setFillColor(sf::Color::Blue);
 }
 
+Tower::~Tower() {
+    if (gamePtr) gamePtr->timers.cancel(reloadTimer);
+}
+
 void Tower::update(float dt) {
     if (gamePtr) {
         update(dt, *gamePtr);
     }
 }
 
+const char* targetPolicyName(TargetPolicy p) {
+    switch (p) {
+        case TargetPolicy::First: return "First";
+        case TargetPolicy::Last: return "Last";
+        case TargetPolicy::Strongest: return "Strongest";
+        case TargetPolicy::Weakest: return "Weakest";
+        case TargetPolicy::Closest:
+        default: return "Closest";
+    }
+}
+
 void Tower::update(float dt, Game& game) {
-    cooldown -= dt;
-    if (cooldown < 0) cooldown = 0;
+    // a reloading tower with no target has nothing to do until its timer fires
+    if (reloading && currentTarget.expired()) return;
 
     if (auto target = currentTarget.lock()) {
-        if (!isValidTarget(target, game))
+        // a different serial means the enemy died and was recycled by Game
+        if (target->getSerial() != targetSerial || !isValidTarget(target, game))
             currentTarget.reset();
     }
 
-    if (currentTarget.expired())
-        currentTarget = findTarget(game);
+    updateBand(game);
+    // closest sticks to its target; the other policies pick again before each
+    // shot, the order they rank by changes while the target is still in range
+    if (currentTarget.expired() || (policy != TargetPolicy::Closest && !reloading)) {
+        auto target = findTarget(game);
+        if (target) targetSerial = target->getSerial();
+        currentTarget = target;
+    }
 
     if (updateAngle(dt, game)) {
-        if (cooldown <= 0.f)
+        if (!reloading)
             shoot(game);
     }
 }
 
-std::shared_ptr<Enemy> Tower::findTarget(const Game& game) const {
-    std::shared_ptr<Enemy> best;
-    float bestDist = range;
+void Tower::updateBand(const Game& game) {
+    std::uint64_t stamp = game.targetingStamp();
+    if (stamp == bandStamp) return;
+    bandStamp = stamp;
+    const Map& m = game.getMap();
+    float ts = m.getTileSize();
+    float reach = range + ts;
+    int x0 = std::max(0, static_cast<int>((pos.x - reach) / ts));
+    int y0 = std::max(0, static_cast<int>((pos.y - reach) / ts));
+    int x1 = std::min(m.getCols() - 1, static_cast<int>((pos.x + reach) / ts));
+    int y1 = std::min(m.getRows() - 1, static_cast<int>((pos.y + reach) / ts));
+    int lo = -1, hi = -1;
+    for (int c = 0; c < MoveClassCount; ++c) {
+        if (game.classFields[c].live <= 0) continue;
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                // any part of the tile within range, plus a tile of margin: an
+                // enemy on a blocked tile is keyed by the neighbour it heads for
+                float nx = std::clamp(pos.x, x * ts, (x + 1) * ts) - pos.x;
+                float ny = std::clamp(pos.y, y * ts, (y + 1) * ts) - pos.y;
+                if (nx * nx + ny * ny > reach * reach) continue;
+                int d = game.getDistanceAt(x, y, static_cast<MoveClass>(c));
+                if (d < 0) continue;
+                if (lo < 0 || d < lo) lo = d;
+                hi = std::max(hi, d);
+            }
+        }
+    }
+    // an enemy on a tile of value d has a key between d - (cost of that tile)
+    // and d; a tile costs at most 3 (Game::tileCost)
+    bandLo = static_cast<float>(lo - 3);
+    bandHi = static_cast<float>(hi);
+    if (lo < 0) bandHi = -1.f; // empty
+}
 
-    for (auto& e : game.enemies) {
-        if (!e->isAlive()) continue;
+std::shared_ptr<Enemy> Tower::findTarget(const Game& game) const {
+    const ProgressIndex& index = game.progress;
+    const float r2 = range * range;
+    auto inRange = [&](const Enemy* e) {
+        if (!e->isAlive()) return false;
+        sf::Vector2f d = e->getPosition() - pos;
+        return d.x * d.x + d.y * d.y <= r2;
+    };
+
+    Enemy* best = nullptr;
+    if (policy == TargetPolicy::First || policy == TargetPolicy::Last) {
+        size_t begin = bandHi >= bandLo ? index.lowerBound(bandLo) : index.rankedEnd();
+        size_t end = bandHi >= bandLo ? index.upperBound(bandHi) : begin;
+        size_t ranked = index.rankedEnd();
+        if (policy == TargetPolicy::First) {
+            for (size_t i = begin; i < end && !best; ++i)
+                if (inRange(index[i].enemy)) best = index[i].enemy;
+        } else {
+            for (size_t i = end; i > begin && !best; --i)
+                if (inRange(index[i - 1].enemy)) best = index[i - 1].enemy;
+        }
+        // enemies with no path rank after everyone
+        for (size_t i = ranked; i < index.size() && !best; ++i)
+            if (inRange(index[i].enemy)) best = index[i].enemy;
+        return best ? best->shared_from_this() : nullptr;
+    }
 
-        float d = length(e->getPosition() - pos);
-        if (d <= range && d < bestDist) {
+    float bestScore = 0.f;
+    auto consider = [&](Enemy* e) {
+        if (!inRange(e)) return;
+        float score;
+        switch (policy) {
+            case TargetPolicy::Strongest: score = -e->getHP(); break;
+            case TargetPolicy::Weakest: score = e->getHP(); break;
+            default: score = length(e->getPosition() - pos); break;
+        }
+        if (!best || score < bestScore) {
             best = e;
-            bestDist = d;
+            bestScore = score;
         }
-    }
-    return best;
+    };
+    // the other policies rank every enemy in range: the enemy grid gives them
+    // directly (cells under the range square), path or no path
+    const SpatialGrid& grid = game.enemyGrid;
+    const auto& items = grid.items();
+    int cx0 = grid.cellX(pos.x - range), cx1 = grid.cellX(pos.x + range);
+    int cy0 = grid.cellY(pos.y - range), cy1 = grid.cellY(pos.y + range);
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            for (int k = grid.cellBegin(cx, cy); k < grid.cellEnd(cx, cy); ++k) consider(game.enemies[items[k]].get());
+    return best ? best->shared_from_this() : nullptr;
 }
 
 bool Tower::isValidTarget(const std::shared_ptr<Enemy>& e, const Game& game) const {
@@ -94,23 +188,41 @@ void Tower::shoot(Game& game) {
     auto t = currentTarget.lock();
     if (!t) return;
 
-    sf::Vector2f dir = normalize(t->getPosition() - pos);
+    game.fireProjectile(*this, t, 300.f, damage, 0);
 
-    game.projectiles.push_back(
-        std::make_unique<Projectile>(pos, dir, 300.f, damage, &game, 0)
-    );
+    startCooldown(game);
+}
 
-    cooldown = 1.f / fireRate;
+void Tower::startCooldown(Game& game) {
+    reloading = true;
+    game.timers.cancel(reloadTimer);
+    reloadTimer = game.timers.schedule(1.f / fireRate, [this]() {
+        reloading = false;
+        reloadTimer = TimerWheel::InvalidTimer;
+    });
 }
 
 void Tower::upgrade() {
     level++;
+    upgradesPaid += upgradeCost;
+    upgradeCost += upgradeCost / 2;
+    bandStamp = ~0ull; // the range grows
     damage *= 1.4f;
     range += 20.f;
     fireRate += 0.2f;
     baseShape.setFillColor(sf::Color(100, 100, 255)); // lighter blue
 }
 
+void Tower::drawRange(sf::RenderWindow& window, const sf::Color& color) const {
+    if (!showRange) return;
+    sf::CircleShape rangeCircle(range);
+    rangeCircle.setPosition(pos - sf::Vector2f(range, range));
+    rangeCircle.setFillColor(sf::Color::Transparent);
+    rangeCircle.setOutlineThickness(1.f);
+    rangeCircle.setOutlineColor(color);
+    window.draw(rangeCircle);
+}
+
 void Tower::render(sf::RenderWindow& window) {
     baseShape.setRotation(angle * 180.f / M_PI);
     baseShape.setPosition(pos);
@@ -25,12 +25,7 @@ void SniperTower::render(sf::RenderWindow& window) {
     window.draw(base);
 
     // Range indicator (dashed red circle)
-    sf::CircleShape rangeCircle(range);
-    rangeCircle.setPosition(pos - sf::Vector2f(range, range));
-    rangeCircle.setFillColor(sf::Color::Transparent);
-    rangeCircle.setOutlineThickness(1.f);
-    rangeCircle.setOutlineColor(sf::Color(200, 50, 50, 100));
-    window.draw(rangeCircle);
+    drawRange(window, sf::Color(200, 50, 50, 100));
 
     // Barrel (longer for sniper)
     sf::RectangleShape barrel(sf::Vector2f(20.f, 4.f));
@@ -62,12 +57,7 @@ void FreezingTower::render(sf::RenderWindow& window) {
     window.draw(base);
 
     // Range indicator (cyan circle)
-    sf::CircleShape rangeCircle(range);
-    rangeCircle.setPosition(pos - sf::Vector2f(range, range));
-    rangeCircle.setFillColor(sf::Color::Transparent);
-    rangeCircle.setOutlineThickness(1.f);
-    rangeCircle.setOutlineColor(sf::Color(100, 200, 255, 100));
-    window.draw(rangeCircle);
+    drawRange(window, sf::Color(100, 200, 255, 100));
 
     // Barrel (normal)
     sf::RectangleShape barrel(sf::Vector2f(15.f, 4.f));
@@ -99,12 +89,7 @@ void CannonTower::render(sf::RenderWindow& window) {
     window.draw(base);
 
     // Range indicator (yellow circle)
-    sf::CircleShape rangeCircle(range);
-    rangeCircle.setPosition(pos - sf::Vector2f(range, range));
-    rangeCircle.setFillColor(sf::Color::Transparent);
-    rangeCircle.setOutlineThickness(1.f);
-    rangeCircle.setOutlineColor(sf::Color(255, 200, 0, 100));
-    window.draw(rangeCircle);
+    drawRange(window, sf::Color(255, 200, 0, 100));
 
     // Barrel (thicker for cannon)
     sf::RectangleShape barrel(sf::Vector2f(18.f, 6.f));
@@ -129,12 +114,11 @@ void CannonTower::shoot(Game& game) {
 
     // Create primary projectile
     // Use the fire sprite for cannon projectile if available (projType 1)
-    game.projectiles.push_back(
-        std::make_unique<Projectile>(pos, direction, 250.f, damage, &game, 1)
-    );
+    game.fireProjectile(*this, target, 250.f, damage, 1);
 
     // AOE explosion: damage all enemies within explosionRadius of target position
     sf::Vector2f explosionCenter = target->getPosition() + direction * 100.f;
+    game.particles.explosion(explosionCenter, explosionRadius * 0.5f);
     for (auto& e : game.enemies) {
         if (!e->isAlive()) continue;
 
@@ -142,12 +126,13 @@ void CannonTower::shoot(Game& game) {
         float distToExplosion = std::sqrt(delta2.x * delta2.x + delta2.y * delta2.y);
 
         if (distToExplosion <= explosionRadius) {
-            e->takeDamage(damage * 0.7f);  // 70% damage in AOE
+            e->takeDamage(damage * 0.7f, id);  // 70% damage in AOE
+            if (e->isAlive()) e->applyStun(0.3f); // blast knocks survivors off their feet
         }
     }
 
     // Reset cooldown
-    cooldown = 1.f / fireRate;
+    startCooldown(game);
 }
 
 // Sniper tower shoots larger bullets (projType 2)
@@ -157,9 +142,6 @@ void SniperTower::shoot(Game& game) {
     sf::Vector2f delta = t->getPosition() - pos;
     float dist = std::sqrt(delta.x * delta.x + delta.y * delta.y);
     if (dist <= 0.1f) return;
-    sf::Vector2f direction = delta / dist;
-    game.projectiles.push_back(
-        std::make_unique<Projectile>(pos, direction, 500.f, damage, &game, 2)
-    );
-    cooldown = 1.f / fireRate;
+    game.fireProjectile(*this, t, 500.f, damage, 2);
+    startCooldown(game);
 }
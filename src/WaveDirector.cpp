@@ -0,0 +1,223 @@
+#include "WaveDirector.h"
+#include "Game.h"
+#include <algorithm>
+#include <new>
+
+WaveDirector::WaveDirector(Game& g) : game(g), pool(new unsigned char[BlockSize * BlockCount]) {
+    for (int i = BlockCount - 1; i >= 0; --i) freeBlocks[freeCount++] = pool.get() + i * BlockSize;
+    detached.reserve(16);
+    std::string error;
+    script.parse(WaveScript::builtIn(), error);
+}
+
+WaveDirector::~WaveDirector() {
+    stop();
+}
+
+// --- frames ---
+
+void* WaveDirector::allocFrame(std::size_t n) {
+    unsigned char* block;
+    WaveDirector* owner = nullptr;
+    if (n + HeaderSize <= BlockSize && freeCount > 0) {
+        block = static_cast<unsigned char*>(freeBlocks[--freeCount]);
+        owner = this;
+    } else {
+        block = static_cast<unsigned char*>(::operator new(n + HeaderSize));
+    }
+    *reinterpret_cast<WaveDirector**>(block) = owner;
+    return block + HeaderSize;
+}
+
+void WaveDirector::freeFrame(void* p, std::size_t) {
+    unsigned char* block = static_cast<unsigned char*>(p) - HeaderSize;
+    WaveDirector* owner = *reinterpret_cast<WaveDirector**>(block);
+    if (owner) owner->freeBlocks[owner->freeCount++] = block;
+    else ::operator delete(block);
+}
+
+WaveDirector::Task& WaveDirector::Task::operator=(Task&& o) noexcept {
+    if (this != &o) {
+        if (handle) handle.destroy();
+        handle = o.handle;
+        o.handle = {};
+    }
+    return *this;
+}
+
+std::coroutine_handle<> WaveDirector::Task::promise_type::Final::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept {
+    promise_type& p = h.promise();
+    if (WaveDirector* d = p.detachedFrom) {
+        // nobody awaits an async burst: it frees itself
+        auto it = std::find(d->detached.begin(), d->detached.end(), h);
+        if (it != d->detached.end()) {
+            *it = d->detached.back();
+            d->detached.pop_back();
+        }
+        h.destroy();
+        return std::noop_coroutine();
+    }
+    return p.continuation ? p.continuation : std::noop_coroutine();
+}
+
+// --- awaitables ---
+
+void WaveDirector::Delay::await_suspend(std::coroutine_handle<> h) {
+    if (seconds >= 0.f) d.game.timers.schedule(seconds, [h]() { h.resume(); });
+    else d.game.timers.scheduleTicks(ticks, [h]() { h.resume(); });
+}
+
+bool WaveDirector::isClear() const {
+    return game.liveEnemies == 0 && activeBursts == 0 && !game.gameOver;
+}
+
+bool WaveDirector::Condition::await_ready() const noexcept {
+    return spawnedOnly ? d.activeBursts == 0 : d.isClear();
+}
+
+void WaveDirector::Condition::await_suspend(std::coroutine_handle<> h) {
+    int& n = spawnedOnly ? d.spawnedWaiterCount : d.clearWaiterCount;
+    std::coroutine_handle<>* list = spawnedOnly ? d.spawnedWaiters : d.clearWaiters;
+    // only the match coroutine waits on these: a full list is a bug
+    if (n < MaxWaiters) list[n++] = h;
+}
+
+void WaveDirector::fieldChanged() {
+    if (!isClear() || clearWaiterCount == 0) return;
+    // resumed coroutines may wait again: take the list first
+    std::coroutine_handle<> ready[MaxWaiters];
+    int n = clearWaiterCount;
+    std::copy(clearWaiters, clearWaiters + n, ready);
+    clearWaiterCount = 0;
+    for (int i = 0; i < n; ++i) ready[i].resume();
+}
+
+void WaveDirector::burstFinished() {
+    if (--activeBursts > 0) return;
+    game.spawnPortalPulse.set(game.simTime, game.spawnPortalPulse.at(game.simTime), -1.2f);
+    std::coroutine_handle<> ready[MaxWaiters];
+    int n = spawnedWaiterCount;
+    std::copy(spawnedWaiters, spawnedWaiters + n, ready);
+    spawnedWaiterCount = 0;
+    for (int i = 0; i < n; ++i) ready[i].resume();
+    fieldChanged();
+}
+
+// --- coroutines ---
+
+void WaveDirector::setScript(const WaveScript& s) {
+    if (match.handle) pendingScript = s;
+    else script = s;
+}
+
+void WaveDirector::start() {
+    stop();
+    if (pendingScript) {
+        script = std::move(*pendingScript);
+        pendingScript.reset();
+    }
+    match = runMatch();
+    match.handle.resume();
+}
+
+void WaveDirector::stop() {
+    // the match frame owns the burst it awaits; async ones are listed
+    match = Task();
+    for (Task::Handle h : detached) h.destroy();
+    detached.clear();
+    activeBursts = 0;
+    clearWaiterCount = spawnedWaiterCount = 0;
+    game.spawnQueue.clear();
+    game.pendingSpawns = 0;
+}
+
+void WaveDirector::detach(Task t) {
+    Task::Handle h = t.handle;
+    t.handle = {};
+    h.promise().detachedFrom = this;
+    detached.push_back(h);
+    h.resume();
+}
+
+WaveDirector::Task WaveDirector::runMatch() {
+    for (int wave = 0;;) {
+        if (pendingScript) {
+            script = std::move(*pendingScript);
+            pendingScript.reset();
+        }
+        game.currentWave = wave;
+        // the script is only swapped between waves: the block stays valid
+        if (const WaveBlock* block = script.blockFor(wave)) {
+            for (const WaveOp& op : block->ops) {
+                switch (op.kind) {
+                    case WaveOp::Kind::Spawn:
+                        if (op.async) detach(burst(op, wave));
+                        else co_await burst(op, wave);
+                        break;
+                    case WaveOp::Kind::Wait:
+                        co_await after(std::max(0.f, op.seconds.at(wave)));
+                        break;
+                    case WaveOp::Kind::WaitClear:
+                        co_await clear();
+                        break;
+                    case WaveOp::Kind::WaitSpawned:
+                        co_await spawned();
+                        break;
+                }
+            }
+        }
+        co_await clear();
+        co_await after(script.cooldown);
+        wave = game.pinnedWave >= 0 ? game.pinnedWave : wave + 1;
+    }
+}
+
+WaveDirector::Task WaveDirector::burst(WaveOp op, int wave) {
+    Game& g = game;
+    // spawn tiles (value 4): bursts are spread across all of them
+    g.spawnPoints = g.getMap().getSpawns();
+    if (g.spawnPoints.empty()) g.spawnPoints.emplace_back(0, std::min(g.getMap().getRows() - 1, 6));
+    const int lanes = static_cast<int>(g.spawnPoints.size());
+
+    // every type is drawn up front, so the rng sequence does not depend on
+    // how bursts interleave; the queue is shared by the bursts in flight
+    if (activeBursts == 0) g.spawnQueue.clear();
+    ++activeBursts;
+    const size_t first = g.spawnQueue.size();
+    const int count = std::max(0, op.count.count(wave));
+    const float hp = std::max(1.f, op.hp.at(wave));
+    int totalWeight = 0;
+    for (int k = 0; k < op.mixCount; ++k) totalWeight += op.mixWeight[k];
+    for (int i = 0; i < count; ++i) {
+        int type = op.mixType[0];
+        if (op.mixCount > 1) {
+            int r = g.randomInt(totalWeight);
+            for (int k = 0; k < op.mixCount; ++k) {
+                if (r < op.mixWeight[k]) { type = op.mixType[k]; break; }
+                r -= op.mixWeight[k];
+            }
+        }
+        // round-robin over the spawns so every lane gets its share
+        int lane = op.lane >= 0 ? op.lane % lanes : i % lanes;
+        g.spawnQueue.push_back({type, hp, lane});
+    }
+    const size_t end = g.spawnQueue.size();
+    g.pendingSpawns += count;
+    g.reserveEntityStorage();
+    g.spawnPortalPulse.set(g.simTime, g.spawnPortalPulse.at(g.simTime), 2.5f);
+
+    // first release on the next tick, then one every interval: one enemy per
+    // spawn point, or one at a time on a fixed lane
+    const int perRelease = op.lane >= 0 ? 1 : lanes;
+    if (count > 0) co_await afterTicks(1);
+    for (size_t next = first; next < end;) {
+        for (int k = 0; k < perRelease && next < end; ++k) {
+            g.spawnEnemy(g.spawnQueue[next++]);
+            --g.pendingSpawns;
+        }
+        // 0.8-0.05w goes negative from wave 17: every tick from there on
+        if (next < end) co_await after(std::max(0.f, op.seconds.at(wave)));
+    }
+    burstFinished();
+}
@@ -0,0 +1,154 @@
+#include "WaveScript.h"
+#include <sstream>
+#include <cstdlib>
+
+namespace {
+bool parseFloat(const std::string& s, float& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    out = std::strtof(s.c_str(), &end);
+    return end == s.c_str() + s.size();
+}
+
+bool parseInt(const std::string& s, int& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    long v = std::strtol(s.c_str(), &end, 10);
+    out = static_cast<int>(v);
+    return end == s.c_str() + s.size();
+}
+
+// "b", "b+kw", "b-kw", "kw", "w"
+bool parseValue(const std::string& s, WaveValue& out) {
+    out = {};
+    if (s.empty()) return false;
+    if (s.back() != 'w') return parseFloat(s, out.base);
+    std::string body = s.substr(0, s.size() - 1);
+    size_t split = body.find_last_of("+-");
+    std::string base = split == std::string::npos || split == 0 ? "" : body.substr(0, split);
+    std::string coef = split == std::string::npos || split == 0 ? body : body.substr(split);
+    if (!base.empty() && !parseFloat(base, out.base)) return false;
+    if (coef.empty() || coef == "+") out.perWave = 1.f;
+    else if (coef == "-") out.perWave = -1.f;
+    else if (!parseFloat(coef, out.perWave)) return false;
+    return true;
+}
+
+// a constant below 0 is a typo; values that grow with w may still reach it,
+// they are clamped where used
+bool parseNonNegative(const std::string& s, WaveValue& out) {
+    return parseValue(s, out) && (out.perWave != 0.f || out.base >= 0.f);
+}
+}
+
+bool WaveScript::parse(const std::string& text, std::string& error) {
+    WaveScript s;
+    std::istringstream in(text);
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](const std::string& what) {
+        error = "line " + std::to_string(lineNo) + ": " + what;
+        return false;
+    };
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ss(line);
+        std::vector<std::string> tok;
+        for (std::string t; ss >> t;) tok.push_back(t);
+        if (tok.empty()) continue;
+        const std::string& cmd = tok[0];
+
+        if (cmd == "cooldown") {
+            if (tok.size() != 2 || !parseFloat(tok[1], s.cooldown) || s.cooldown < 0.f) return fail("cooldown SECONDS");
+        } else if (cmd == "wave") {
+            // "wave 3", "wave 0-2", "wave 6+"
+            if (tok.size() != 2) return fail("wave N, wave A-B or wave N+");
+            WaveBlock b;
+            const std::string& r = tok[1];
+            size_t dash = r.find('-');
+            bool ok;
+            if (!r.empty() && r.back() == '+') ok = parseInt(r.substr(0, r.size() - 1), b.first);
+            else if (dash != std::string::npos) ok = parseInt(r.substr(0, dash), b.first) && parseInt(r.substr(dash + 1), b.last);
+            else {
+                ok = parseInt(r, b.first);
+                b.last = b.first;
+            }
+            if (!ok || b.first < 0 || (b.last >= 0 && b.last < b.first)) return fail("bad wave range '" + r + "'");
+            s.blocks.push_back(std::move(b));
+        } else if (cmd == "spawn" || cmd == "wait") {
+            if (s.blocks.empty()) return fail("'" + cmd + "' before any 'wave'");
+            WaveOp op;
+            if (cmd == "wait") {
+                if (tok.size() != 2) return fail("wait SECONDS, wait clear or wait spawned");
+                if (tok[1] == "clear") op.kind = WaveOp::Kind::WaitClear;
+                else if (tok[1] == "spawned") op.kind = WaveOp::Kind::WaitSpawned;
+                else {
+                    op.kind = WaveOp::Kind::Wait;
+                    if (!parseNonNegative(tok[1], op.seconds)) return fail("bad delay '" + tok[1] + "'");
+                }
+            } else {
+                if (tok.size() < 2 || !parseNonNegative(tok[1], op.count)) return fail("spawn COUNT ...");
+                for (size_t i = 2; i < tok.size(); ++i) {
+                    const std::string& key = tok[i];
+                    bool hasArg = i + 1 < tok.size();
+                    if (key == "async") {
+                        op.async = true;
+                    } else if (key == "type" && hasArg) {
+                        op.mixCount = 1;
+                        op.mixWeight[0] = 1;
+                        if (!parseInt(tok[++i], op.mixType[0])) return fail("bad type '" + tok[i] + "'");
+                    } else if (key == "mix" && hasArg) {
+                        // TYPE:WEIGHT entries up to the next keyword
+                        op.mixCount = 0;
+                        while (i + 1 < tok.size() && tok[i + 1].find(':') != std::string::npos) {
+                            const std::string& e = tok[++i];
+                            size_t c = e.find(':');
+                            if (op.mixCount == WaveOp::MaxMix) return fail("at most 4 types in a mix");
+                            int& t = op.mixType[op.mixCount];
+                            int& w = op.mixWeight[op.mixCount];
+                            if (!parseInt(e.substr(0, c), t) || !parseInt(e.substr(c + 1), w) || w <= 0)
+                                return fail("bad mix entry '" + e + "'");
+                            ++op.mixCount;
+                        }
+                    } else if (key == "hp" && hasArg) {
+                        if (!parseNonNegative(tok[++i], op.hp)) return fail("bad hp '" + tok[i] + "'");
+                    } else if (key == "every" && hasArg) {
+                        if (!parseNonNegative(tok[++i], op.seconds)) return fail("bad interval '" + tok[i] + "'");
+                    } else if (key == "lane" && hasArg) {
+                        if (!parseInt(tok[++i], op.lane) || op.lane < 0) return fail("bad lane '" + tok[i] + "'");
+                    } else {
+                        return fail("unknown spawn option '" + key + "'");
+                    }
+                }
+                if (op.mixCount == 0) return fail("spawn needs 'type T' or 'mix T:W ...'");
+                for (int k = 0; k < op.mixCount; ++k)
+                    if (op.mixType[k] < 1 || op.mixType[k] > 3) return fail("enemy types are 1 to 3");
+            }
+            s.blocks.back().ops.push_back(op);
+        } else {
+            return fail("unknown command '" + cmd + "'");
+        }
+    }
+    *this = std::move(s);
+    return true;
+}
+
+const WaveBlock* WaveScript::blockFor(int wave) const {
+    for (const WaveBlock& b : blocks)
+        if (wave >= b.first && (b.last < 0 || wave <= b.last)) return &b;
+    return nullptr;
+}
+
+const char* WaveScript::builtIn() {
+    return "cooldown 5\n"
+           "wave 0-2\n"
+           "  spawn 3+w type 1\n"
+           "wave 3\n"
+           "  spawn 3+w type 2\n"
+           "wave 4-5\n"
+           "  spawn 3+w mix 2:70 1:30\n"
+           "wave 6+\n"
+           "  spawn 3+w mix 3:20 2:40 1:40\n";
+}
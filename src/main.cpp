@@ -1,7 +1,89 @@
 #include "Game.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
-int main() {
+int main(int argc, char** argv) {
+    // --seed N: fixed match seed (same seed + same inputs = same match)
+    // --speed N: headless runs step through the fast-forward path at xN
+    // --net-latency MS, --net-jitter MS, --net-loss PCT: simulated co-op link
+    // --coverage-out FILE: headless runs write the tower coverage map there
+    bool seedFixed = false;
+    unsigned seed = 0;
+    int speed = 1;
+    int latencyMs = 0, jitterMs = 0, desyncAt = -1;
+    float lossPct = 0.f;
+    const char* coverageOut = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--seed") == 0) {
+            seedFixed = true;
+            seed = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--speed") == 0) {
+            speed = std::max(1, std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--net-latency") == 0) {
+            latencyMs = std::max(0, std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--net-jitter") == 0) {
+            jitterMs = std::max(0, std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--net-loss") == 0) {
+            lossPct = static_cast<float>(std::atof(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--net-desync") == 0) {
+            desyncAt = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--coverage-out") == 0) {
+            coverageOut = argv[i + 1];
+        }
+    }
+    // --headless [ticks]: simulation only, no window
+    // --alloc-test [ticks]: headless, fails if a steady-state tick allocates
+    // --net-test [ticks]: two headless co-op games over localhost (default
+    //   link 60 ms +20 jitter, 10% loss); --net-desync N tampers with one at tick N
+    // --hit-test: collision hits of two shots on one enemy within a tick
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--hit-test") == 0) return Game::runHitTest();
+        bool allocTest = std::strcmp(argv[i], "--alloc-test") == 0;
+        bool netTest = std::strcmp(argv[i], "--net-test") == 0;
+        if (!allocTest && !netTest && std::strcmp(argv[i], "--headless") != 0) continue;
+        int ticks = 60 * 60;
+        if (i + 1 < argc && argv[i + 1][0] != '-') ticks = std::max(1, std::atoi(argv[i + 1]));
+        if (netTest) {
+            bool custom = latencyMs || jitterMs || lossPct > 0.f;
+            return Game::runNetTest(ticks, sf::milliseconds(custom ? latencyMs : 60), sf::milliseconds(custom ? jitterMs : 20),
+                                    (custom ? lossPct : 10.f) / 100.f, desyncAt);
+        }
+        Game g(true);
+        g.seedFixed = seedFixed;
+        g.matchSeed = seed;
+        if (coverageOut) g.coverageOut = coverageOut;
+        return g.runHeadless(ticks, allocTest, speed);
+    }
     Game g;
+    g.seedFixed = seedFixed;
+    g.matchSeed = seed;
+    // --vsync: pace on the display; --fps N: software cap (0 = uncapped)
+    // --host PORT / --join ADDRESS PORT: two-player co-op
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--vsync") == 0) g.vsync = true;
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) g.frameCap = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            g.net = std::make_unique<Lockstep>();
+            unsigned short port = static_cast<unsigned short>(std::atoi(argv[++i]));
+            if (!g.net->host(port, seedFixed ? seed : std::random_device{}())) {
+                std::cerr << "Cannot listen on UDP port " << port << std::endl;
+                return 1;
+            }
+            std::cout << "Co-op: waiting for player 2 on port " << port << std::endl;
+        } else if (std::strcmp(argv[i], "--join") == 0 && i + 2 < argc) {
+            g.net = std::make_unique<Lockstep>();
+            sf::IpAddress address(argv[i + 1]);
+            unsigned short port = static_cast<unsigned short>(std::atoi(argv[i + 2]));
+            i += 2;
+            if (!g.net->join(address, port)) {
+                std::cerr << "Cannot open a UDP socket" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (g.net) g.net->simulateLink(sf::milliseconds(latencyMs), sf::milliseconds(jitterMs), lossPct / 100.f);
     g.run();
     return 0;
 }
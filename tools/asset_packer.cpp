@@ -0,0 +1,104 @@
+// Build-time asset packer: walks assets/, decodes every PNG to raw RGBA once
+// and writes a single assets.pack (see include/AssetPack.h for the layout).
+// usage: asset_packer <assets dir> <output .pack>
+#include "AssetPack.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Item {
+    std::string name;
+    std::uint32_t kind = PackRaw;
+    std::uint32_t width = 0, height = 0;
+    std::uint32_t mtime = 0;
+    std::vector<unsigned char> data;
+};
+
+static std::uint64_t alignUp(std::uint64_t v) { return (v + 15) & ~std::uint64_t(15); }
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: asset_packer <assets dir> <output .pack>\n";
+        return 2;
+    }
+    fs::path root = argv[1];
+    std::vector<Item> items;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file()) continue;
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (ext != ".png" && ext != ".txt") continue;
+
+        Item it;
+        it.name = entry.path().lexically_relative(root).generic_string();
+        if (it.name.size() >= sizeof(PackEntry::name)) {
+            std::cerr << "asset_packer: name too long: " << it.name << "\n";
+            return 1;
+        }
+        // lets the game tell a file saved after the build from the packed copy
+        it.mtime = AssetPack::fileTime(entry.path().string());
+        if (ext == ".png") {
+            sf::Image img;
+            if (!img.loadFromFile(entry.path().string())) {
+                std::cerr << "asset_packer: cannot decode " << entry.path() << "\n";
+                return 1;
+            }
+            it.kind = PackImage;
+            it.width = img.getSize().x;
+            it.height = img.getSize().y;
+            const sf::Uint8* px = img.getPixelsPtr();
+            it.data.assign(px, px + size_t(it.width) * it.height * 4);
+        } else {
+            std::ifstream in(entry.path(), std::ios::binary);
+            it.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        items.push_back(std::move(it));
+    }
+    // the runtime looks entries up by binary search
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.name < b.name; });
+
+    PackHeader header{};
+    std::memcpy(header.magic, "TDPK", 4);
+    header.version = PackVersion;
+    header.count = static_cast<std::uint32_t>(items.size());
+
+    std::vector<PackEntry> table(items.size());
+    std::uint64_t offset = alignUp(sizeof(PackHeader) + table.size() * sizeof(PackEntry));
+    for (size_t i = 0; i < items.size(); ++i) {
+        PackEntry& e = table[i];
+        std::memset(&e, 0, sizeof(e));
+        std::memcpy(e.name, items[i].name.data(), items[i].name.size());
+        e.kind = items[i].kind;
+        e.width = items[i].width;
+        e.height = items[i].height;
+        e.mtime = items[i].mtime;
+        e.offset = offset;
+        e.size = items[i].data.size();
+        offset = alignUp(offset + e.size);
+    }
+
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "asset_packer: cannot write " << argv[2] << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(PackEntry)));
+    const char zeros[16] = {};
+    std::uint64_t written = sizeof(header) + table.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < items.size(); ++i) {
+        out.write(zeros, std::streamsize(table[i].offset - written));
+        out.write(reinterpret_cast<const char*>(items[i].data.data()), std::streamsize(items[i].data.size()));
+        written = table[i].offset + items[i].data.size();
+    }
+    out.write(zeros, std::streamsize(alignUp(written) - written));
+    std::cout << "asset_packer: " << items.size() << " assets, " << alignUp(written) << " bytes\n";
+    return out ? 0 : 1;
+}